@@ -0,0 +1,71 @@
+# Everything of the application except main(), shared with the bench and
+# workload tools so their lists do not drift from the application's
+QT *= core gui widgets sql printsupport concurrent
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/mainwindow.cpp \
+    $$PWD/productmanagerwidget.cpp \
+    $$PWD/producteditor.cpp \
+    $$PWD/product.cpp \
+    $$PWD/productlistwidget.cpp \
+    $$PWD/productsearchindex.cpp \
+    $$PWD/productrowstore.cpp \
+    $$PWD/connectionpool.cpp \
+    $$PWD/productlistsnapshot.cpp \
+    $$PWD/checksum.cpp \
+    $$PWD/databaseconnector.cpp \
+    $$PWD/trace.cpp \
+    $$PWD/sql.cpp \
+    $$PWD/sqlstats.cpp \
+    $$PWD/pricetable.cpp \
+    $$PWD/pricebook.cpp \
+    $$PWD/bulkrepricer.cpp \
+    $$PWD/repricedialog.cpp \
+    $$PWD/costingengine.cpp \
+    $$PWD/productimporter.cpp \
+    $$PWD/productimportdialog.cpp \
+    $$PWD/productexporter.cpp \
+    $$PWD/backgroundjobdialog.cpp \
+    $$PWD/productcatalogreader.cpp \
+    $$PWD/pricelistprinter.cpp \
+    $$PWD/pagespooler.cpp \
+    $$PWD/code128.cpp \
+    $$PWD/labelprinter.cpp \
+    $$PWD/labeldialog.cpp
+
+HEADERS += \
+    $$PWD/global.h \
+    $$PWD/mainwindow.h \
+    $$PWD/productmanagerwidget.h \
+    $$PWD/producteditor.h \
+    $$PWD/product.h \
+    $$PWD/productlistwidget.h \
+    $$PWD/productsearchindex.h \
+    $$PWD/productrowstore.h \
+    $$PWD/connectionpool.h \
+    $$PWD/productlistsnapshot.h \
+    $$PWD/checksum.h \
+    $$PWD/databaseconnector.h \
+    $$PWD/trace.h \
+    $$PWD/sql.h \
+    $$PWD/sqlstats.h \
+    $$PWD/pricetable.h \
+    $$PWD/pricebook.h \
+    $$PWD/bulkrepricer.h \
+    $$PWD/repricedialog.h \
+    $$PWD/costingengine.h \
+    $$PWD/productimporter.h \
+    $$PWD/productimportdialog.h \
+    $$PWD/productexporter.h \
+    $$PWD/backgroundjobdialog.h \
+    $$PWD/productcatalogreader.h \
+    $$PWD/pricelistprinter.h \
+    $$PWD/pagespooler.h \
+    $$PWD/code128.h \
+    $$PWD/labelprinter.h \
+    $$PWD/labeldialog.h
+
+FORMS += \
+    $$PWD/mainwindow.ui \
+    $$PWD/producteditor.ui
@@ -1,25 +1,10 @@
 TARGET = shift-ims
 TEMPLATE = app
 DESTDIR = $$PWD/../../dist
-QT = core gui widgets sql printsupport
+QT = core gui widgets sql printsupport concurrent
 RC_FILE = app.rc
 
-SOURCES += \
-    main.cpp \
-    mainwindow.cpp \
-    productmanagerwidget.cpp \
-    producteditor.cpp \
-    product.cpp \
-    productlistwidget.cpp
-
-HEADERS += \
-    global.h \
-    mainwindow.h \
-    productmanagerwidget.h \
-    producteditor.h \
-    product.h \
-    productlistwidget.h
+include(app.pri)
 
-FORMS += \
-    mainwindow.ui \
-    producteditor.ui
+SOURCES += \
+    main.cpp
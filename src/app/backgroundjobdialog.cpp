@@ -0,0 +1,53 @@
+#include "backgroundjobdialog.h"
+
+#include <QtConcurrentRun>
+
+BackgroundJobDialog::BackgroundJobDialog(const QString& title, const QString& progressText, const Job& job, QWidget *parent)
+    : QProgressDialog(parent)
+    , _progressText(progressText)
+    , _cancelled(0)
+{
+    setWindowTitle(title);
+    setLabelText(title + "...");
+    setCancelButtonText("&Batal");
+    setRange(0, 0);
+    setAutoReset(false);
+    setAutoClose(false);
+    setMinimumDuration(0);
+
+    connect(this, SIGNAL(canceled()), SLOT(_onCanceled()));
+    connect(&_watcher, SIGNAL(finished()), SLOT(_onFinished()));
+
+    _pool.setMaxThreadCount(1);
+
+    // Progress comes from the worker thread, it is handed over through the event loop
+    ProgressCallback progress = [this](int done, int total) {
+        QMetaObject::invokeMethod(this, "_onProgress", Qt::QueuedConnection, Q_ARG(int, done), Q_ARG(int, total));
+        return !_cancelled.loadAcquire();
+    };
+
+    QString* error = &_error;
+    _watcher.setFuture(QtConcurrent::run(&_pool, [job, progress, error]() {
+        return job(progress, error);
+    }));
+}
+
+void BackgroundJobDialog::_onProgress(int done, int total)
+{
+    setRange(0, total);
+    setValue(done);
+    setLabelText(_progressText.arg(QLocale().toString(done), QLocale().toString(total)));
+}
+
+void BackgroundJobDialog::_onFinished()
+{
+    if (_watcher.result())
+        accept();
+    else
+        reject();
+}
+
+void BackgroundJobDialog::_onCanceled()
+{
+    _cancelled.storeRelease(1);
+}
@@ -0,0 +1,41 @@
+#ifndef BACKGROUNDJOBDIALOG_H
+#define BACKGROUNDJOBDIALOG_H
+
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <functional>
+
+// Runs a long job on a worker thread while showing its progress.
+// Accepted when the job succeeds, rejected when it failed or was cancelled.
+class BackgroundJobDialog : public QProgressDialog
+{
+    Q_OBJECT
+
+public:
+    // Called from the worker thread, returning false asks the job to stop
+    typedef std::function<bool(int done, int total)> ProgressCallback;
+    typedef std::function<bool(const ProgressCallback& progress, QString* error)> Job;
+
+    // progressText gets the done and total counts as %1 and %2
+    BackgroundJobDialog(const QString& title, const QString& progressText, const Job& job, QWidget *parent = 0);
+
+    QString errorString() const { return _error; }
+
+private slots:
+    void _onProgress(int done, int total);
+    void _onFinished();
+    void _onCanceled();
+
+private:
+    QString _progressText;
+    QString _error;
+    QAtomicInt _cancelled;
+    QFutureWatcher<bool> _watcher;
+
+    // Last, so the worker thread is waited for before anything it uses goes away
+    QThreadPool _pool;
+};
+
+#endif // BACKGROUNDJOBDIALOG_H
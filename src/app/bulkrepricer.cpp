@@ -0,0 +1,278 @@
+#include "bulkrepricer.h"
+#include "pricebook.h"
+#include "connectionpool.h"
+#include "sql.h"
+#include "trace.h"
+
+#include <QtConcurrent>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+#include <algorithm>
+
+namespace {
+
+const int UpdateBatchSize = 1000;
+const int RepriceBatchSize = 10000;
+
+const char* const priceColumns[PriceTable::LevelCount][2] = {
+    { "price1Min", "price1Max" },
+    { "price2Min", "price2Max" },
+    { "price3Min", "price3Max" }
+};
+
+void reprice(BulkRepricer::Change& change, const BulkRepricer::Rule& rule)
+{
+    PriceTable::Tier& tier = change.after;
+
+    for (int level = 0; level < PriceTable::LevelCount; level++) {
+        if (!rule.levels[level])
+            continue;
+
+        quint64 min = tier.priceMin[level];
+        quint64 max = tier.priceMax[level];
+
+        if (rule.kind == BulkRepricer::Rule::MarkupOnCost) {
+            // Without a cost there is nothing to mark up
+            if (!change.cost)
+                continue;
+
+            quint64 price = quint64(qMax(0.0, change.cost * (100.0 + rule.markup[level]) / 100.0) + 0.5);
+            // A range keeps its lowest price at the same ratio of the list price
+            if (min && max && min != max)
+                min = quint64(double(min) * price / max + 0.5);
+            else
+                min = price;
+            max = price;
+        }
+        else {
+            // Levels without a price stay without one
+            if (!min && !max)
+                continue;
+
+            min = quint64(qMax<qint64>(0, qint64(min) + rule.delta[level]));
+            max = quint64(qMax<qint64>(0, qint64(max) + rule.delta[level]));
+        }
+
+        tier.priceMin[level] = BulkRepricer::round(min, rule.rounding);
+        tier.priceMax[level] = BulkRepricer::round(max, rule.rounding);
+    }
+}
+
+bool isChanged(const BulkRepricer::Change& change)
+{
+    for (int level = 0; level < PriceTable::LevelCount; level++) {
+        if (change.before.priceMin[level] != change.after.priceMin[level]
+                || change.before.priceMax[level] != change.after.priceMax[level])
+            return true;
+    }
+    return false;
+}
+
+// True while the stored tier still holds the prices the change was computed from
+QString unchangedCondition(const BulkRepricer::Change& change)
+{
+    const PriceTable::Tier& tier = change.before;
+    QString condition = QString("quantityMin=%1 and quantityMax=%2").arg(tier.quantityMin).arg(tier.quantityMax);
+    for (int level = 0; level < PriceTable::LevelCount; level++) {
+        condition += QString(" and %1=%2 and %3=%4")
+                .arg(priceColumns[level][0]).arg(tier.priceMin[level])
+                .arg(priceColumns[level][1]).arg(tier.priceMax[level]);
+    }
+    return condition;
+}
+
+}
+
+BulkRepricer::Rule::Rule()
+    : kind(MarkupOnCost)
+    , rounding(0)
+{
+    for (int i = 0; i < PriceTable::LevelCount; i++) {
+        markup[i] = 0;
+        delta[i] = 0;
+        levels[i] = true;
+    }
+}
+
+quint64 BulkRepricer::round(quint64 price, quint64 rounding)
+{
+    if (rounding <= 1)
+        return price;
+    return (price + rounding / 2) / rounding * rounding;
+}
+
+bool BulkRepricer::preview(const Filter& filter, const Rule& rule, QVector<Change>* changes,
+                           const ProgressCallback& progress, QString* error)
+{
+    SIMS_TRACE_SCOPE("BulkRepricer::preview");
+
+    auto fail = [error](const QString& text) {
+        if (error)
+            *error = text;
+        return false;
+    };
+
+    ConnectionPool::Lease lease;
+
+    QStringList conditions;
+    if (filter.type != -1)
+        conditions << "p.type=?";
+    if (filter.active != -1)
+        conditions << "p.active=?";
+    if (!filter.name.isEmpty())
+        conditions << "p.name like ?";
+
+    QSqlQuery q(lease.database());
+    q.setForwardOnly(true);
+    q.prepare(QString("select pp.id, pp.productId, p.name, p.cost, pp.quantityMin, pp.quantityMax,"
+                      " pp.price1Min, pp.price1Max, pp.price2Min, pp.price2Max, pp.price3Min, pp.price3Max"
+                      " from product_prices pp"
+                      " inner join products p on p.id=pp.productId"
+                      " where p.type<200%1"
+                      " order by pp.productId, pp.quantityMin")
+              .arg(conditions.isEmpty() ? QString() : " and " + conditions.join(" and ")));
+    if (filter.type != -1)
+        q.addBindValue(filter.type);
+    if (filter.active != -1)
+        q.addBindValue(filter.active);
+    if (!filter.name.isEmpty())
+        q.addBindValue("%" + filter.name + "%");
+
+    if (!Sql::exec(q)) {
+        qDebug() << "SQL ERROR:" << q.lastError().text();
+        return fail(q.lastError().text());
+    }
+
+    QVector<Change> rows;
+    while (q.next()) {
+        Change change;
+        change.id = q.value(0).toULongLong();
+        change.productId = q.value(1).value<quint16>();
+        change.productName = q.value(2).toString();
+        change.cost = quint64(qMax<qint64>(0, q.value(3).toLongLong()));
+        change.before.quantityMin = q.value(4).toULongLong();
+        change.before.quantityMax = q.value(5).toULongLong();
+        for (int i = 0; i < PriceTable::LevelCount; i++) {
+            change.before.priceMin[i] = q.value(6 + i * 2).toULongLong();
+            change.before.priceMax[i] = q.value(7 + i * 2).toULongLong();
+        }
+        change.after = change.before;
+        rows << change;
+    }
+
+    // Each tier is independent, so the rule runs over all cores, a batch at a time for the progress
+    for (int first = 0; first < rows.size(); first += RepriceBatchSize) {
+        int last = qMin(first + RepriceBatchSize, rows.size());
+        QtConcurrent::blockingMap(rows.begin() + first, rows.begin() + last, [&rule](Change& change) {
+            reprice(change, rule);
+        });
+        if (progress && !progress(last, rows.size()))
+            return fail("Pratinjau dibatalkan.");
+    }
+
+    rows.erase(std::remove_if(rows.begin(), rows.end(), [](const Change& change) {
+        return !isChanged(change);
+    }), rows.end());
+
+    changes->swap(rows);
+    return true;
+}
+
+bool BulkRepricer::apply(const QVector<Change>& changes, const ProgressCallback& progress, QString* error)
+{
+    SIMS_TRACE_SCOPE("BulkRepricer::apply");
+
+    auto fail = [error](const QString& text) {
+        if (error)
+            *error = text;
+        return false;
+    };
+
+    if (changes.isEmpty())
+        return true;
+
+    ConnectionPool::Lease lease;
+    QSqlDatabase db = lease.database();
+    QSqlQuery q(db);
+
+    if (!db.transaction()) {
+        qDebug() << __FILE__ << __LINE__ << db.lastError().text();
+        return fail(db.lastError().text());
+    }
+
+    // One update per batch, every price column picks its value by tier id.
+    // Ids and prices are numbers, so they are written into the statement instead of bound.
+    for (int first = 0; first < changes.size(); first += UpdateBatchSize) {
+        int last = qMin(first + UpdateBatchSize, changes.size());
+
+        // A tier only takes its new prices while it still holds the ones the preview
+        // saw, rows someone else changed meanwhile are not matched and fail the apply
+        QStringList ids;
+        ids.reserve(last - first);
+        QString unchanged("case id");
+        for (int i = first; i < last; i++) {
+            ids << QString::number(changes.at(i).id);
+            unchanged += QString(" when %1 then %2").arg(changes.at(i).id).arg(unchangedCondition(changes.at(i)));
+        }
+        unchanged += " end";
+
+        QStringList assignments;
+        for (int level = 0; level < PriceTable::LevelCount; level++) {
+            for (int side = 0; side < 2; side++) {
+                // Columns the rule left alone are not rewritten
+                bool changed = false;
+                for (int i = first; i < last && !changed; i++) {
+                    const Change& change = changes.at(i);
+                    changed = side ? change.before.priceMax[level] != change.after.priceMax[level]
+                                   : change.before.priceMin[level] != change.after.priceMin[level];
+                }
+                if (!changed)
+                    continue;
+
+                QString column(priceColumns[level][side]);
+                QString whenThen("case id");
+                for (int i = first; i < last; i++) {
+                    const PriceTable::Tier& tier = changes.at(i).after;
+                    whenThen += QString(" when %1 then %2")
+                            .arg(changes.at(i).id)
+                            .arg(side ? tier.priceMax[level] : tier.priceMin[level]);
+                }
+                whenThen += " end";
+                assignments << QString("%1=%2").arg(column, whenThen);
+            }
+        }
+
+        if (!Sql::exec(q, QString("update product_prices set %1 where id in (%2) and %3")
+                       .arg(assignments.join(", "), ids.join(','), unchanged))) {
+            qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+            db.rollback();
+            return fail(q.lastError().text());
+        }
+
+        // Every matched tier gets at least one different price, so the affected
+        // count is the matched count on MySQL as well
+        if (q.numRowsAffected() != last - first) {
+            db.rollback();
+            return fail(QString("%1 tingkat harga telah diubah atau dihapus sejak pratinjau dibuat.")
+                        .arg(last - first - qMax(0, q.numRowsAffected())));
+        }
+
+        if (progress && !progress(last, changes.size())) {
+            db.rollback();
+            return fail("Perubahan harga dibatalkan.");
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << __FILE__ << __LINE__ << db.lastError().text();
+        db.rollback();
+        return fail(db.lastError().text());
+    }
+
+    PriceBook::instance()->clear();
+    return true;
+}
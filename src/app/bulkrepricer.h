@@ -0,0 +1,68 @@
+#ifndef BULKREPRICER_H
+#define BULKREPRICER_H
+
+#include "pricetable.h"
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+// Reprices the quantity tiers of many products at once.
+// preview() computes the new prices without touching the database,
+// apply() writes them back in one transaction, and fails without changing
+// anything when a tier no longer holds the prices the preview started from.
+// Both block, run them from a worker thread.
+class BulkRepricer
+{
+public:
+    struct Filter
+    {
+        int type;
+        int active;
+        QString name;
+
+        Filter() : type(-1), active(-1) {}
+    };
+
+    struct Rule
+    {
+        enum Kind {
+            MarkupOnCost,
+            FixedDelta
+        };
+
+        Kind kind;
+        // Per price level, a percentage over cost or an amount added to the current price
+        double markup[PriceTable::LevelCount];
+        qint64 delta[PriceTable::LevelCount];
+        bool levels[PriceTable::LevelCount];
+        // 0 to keep prices as computed, otherwise prices round to the nearest multiple
+        quint64 rounding;
+
+        Rule();
+    };
+
+    struct Change
+    {
+        quint64 id;
+        quint16 productId;
+        QString productName;
+        quint64 cost;
+        PriceTable::Tier before;
+        PriceTable::Tier after;
+    };
+
+    // Called after every batch of tiers, returning false cancels.
+    // A cancelled apply is rolled back as a whole.
+    typedef std::function<bool(int done, int total)> ProgressCallback;
+
+    // Changed tiers only, in product order
+    static bool preview(const Filter& filter, const Rule& rule, QVector<Change>* changes,
+                        const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+    static bool apply(const QVector<Change>& changes,
+                      const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+
+    static quint64 round(quint64 price, quint64 rounding);
+};
+
+#endif // BULKREPRICER_H
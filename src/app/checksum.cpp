@@ -0,0 +1,30 @@
+#include "checksum.h"
+
+namespace {
+
+struct Crc32Table
+{
+    quint32 entries[256];
+
+    Crc32Table()
+    {
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 c = i;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+}
+
+quint32 Checksum::crc32(quint32 crc, const char* data, int size)
+{
+    static const Crc32Table table;
+
+    crc = ~crc;
+    for (int i = 0; i < size; i++)
+        crc = table.entries[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
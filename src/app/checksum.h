@@ -0,0 +1,14 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <QtGlobal>
+
+class Checksum
+{
+public:
+    // The zlib CRC-32, the same one MySQL's crc32() and zip files use.
+    // Pass the previous result as crc to continue over more data.
+    static quint32 crc32(quint32 crc, const char* data, int size);
+};
+
+#endif // CHECKSUM_H
@@ -0,0 +1,109 @@
+#include "code128.h"
+
+namespace {
+
+// Module patterns of symbol values 0 to 105, a bar is a set bit
+const quint16 Patterns[106] = {
+    0x6CC, 0x66C, 0x666, 0x498, 0x48C, 0x44C, 0x4C8, 0x4C4,
+    0x464, 0x648, 0x644, 0x624, 0x59C, 0x4DC, 0x4CE, 0x5CC,
+    0x4EC, 0x4E6, 0x672, 0x65C, 0x64E, 0x6E4, 0x674, 0x76E,
+    0x74C, 0x72C, 0x726, 0x764, 0x734, 0x732, 0x6D8, 0x6C6,
+    0x636, 0x518, 0x458, 0x446, 0x588, 0x468, 0x462, 0x688,
+    0x628, 0x622, 0x5B8, 0x58E, 0x46E, 0x5D8, 0x5C6, 0x476,
+    0x776, 0x68E, 0x62E, 0x6E8, 0x6E2, 0x6EE, 0x758, 0x746,
+    0x716, 0x768, 0x762, 0x71A, 0x77A, 0x642, 0x78A, 0x530,
+    0x50C, 0x4B0, 0x486, 0x42C, 0x426, 0x590, 0x584, 0x4D0,
+    0x4C2, 0x434, 0x432, 0x612, 0x650, 0x7BA, 0x614, 0x47A,
+    0x53C, 0x4BC, 0x49E, 0x5E4, 0x4F4, 0x4F2, 0x7A4, 0x794,
+    0x792, 0x6DE, 0x6F6, 0x7B6, 0x578, 0x51E, 0x45E, 0x5E8,
+    0x5E2, 0x7A8, 0x7A2, 0x5DE, 0x5EE, 0x75E, 0x7AE, 0x684,
+    0x690, 0x69C,
+};
+
+const int SymbolWidth = 11;
+const int StartB = 104;
+// The stop symbol is two modules wider than the others
+const quint16 Stop = 0x18EB;
+const int StopWidth = 13;
+
+// Patterns never cross more than one word boundary, they are at most 13 bits
+inline void append(quint64* words, int position, quint64 pattern, int bits)
+{
+    int offset = position & 63;
+    int end = offset + bits;
+    quint64* word = words + (position >> 6);
+    if (end <= 64) {
+        word[0] |= pattern << (64 - end);
+    }
+    else {
+        word[0] |= pattern >> (end - 64);
+        word[1] |= pattern << (128 - end);
+    }
+}
+
+inline bool isDark(const quint64* words, int position)
+{
+    return (words[position >> 6] >> (63 - (position & 63))) & 1;
+}
+
+}
+
+bool Code128::encode(const QByteArray& text, QVector<quint64>* modules, int* width)
+{
+    if (text.isEmpty())
+        return false;
+
+    const int total = (text.size() + 2) * SymbolWidth + StopWidth;
+    modules->fill(0, (total + 63) / 64);
+    quint64* words = modules->data();
+
+    int position = 0;
+    append(words, position, Patterns[StartB], SymbolWidth);
+    position += SymbolWidth;
+
+    int checksum = StartB;
+    for (int i = 0; i < text.size(); i++) {
+        int value = int(uchar(text.at(i))) - 32;
+        if (value < 0 || value > 95)
+            return false;
+
+        checksum += value * (i + 1);
+        append(words, position, Patterns[value], SymbolWidth);
+        position += SymbolWidth;
+    }
+
+    append(words, position, Patterns[checksum % 103], SymbolWidth);
+    position += SymbolWidth;
+    append(words, position, Stop, StopWidth);
+
+    *width = total;
+    return true;
+}
+
+QVector<Code128::Bar> Code128::bars(const QByteArray& text, int* width)
+{
+    QVector<quint64> modules;
+    int total = 0;
+    QVector<Bar> result;
+    if (!encode(text, &modules, &total))
+        return result;
+
+    // Every symbol has three bars
+    result.reserve(text.size() * 3 + 10);
+    const quint64* words = modules.constData();
+    for (int i = 0; i < total; i++) {
+        if (!isDark(words, i))
+            continue;
+
+        Bar bar;
+        bar.start = quint16(i);
+        while (i + 1 < total && isDark(words, i + 1))
+            i++;
+        bar.width = quint16(i + 1 - bar.start);
+        result << bar;
+    }
+
+    if (width)
+        *width = total;
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef CODE128_H
+#define CODE128_H
+
+#include <QByteArray>
+#include <QVector>
+
+// Code 128 barcodes in code set B, which covers printable ASCII and so
+// every product code. Each symbol is looked up as its 11 module pattern
+// and shifted into 64 bit words, one bit per module, dark modules set.
+class Code128
+{
+public:
+    // Light modules needed on both sides for scanners to find the symbol
+    static const int QuietZone = 10;
+
+    struct Bar
+    {
+        quint16 start;
+        quint16 width;
+    };
+
+    // Start, data, check and stop symbols, most significant bit first.
+    // False when text is empty or has characters outside code set B.
+    static bool encode(const QByteArray& text, QVector<quint64>* modules, int* width);
+
+    // The dark runs of the symbol in modules, ready to be drawn.
+    // Empty when the text cannot be encoded.
+    static QVector<Bar> bars(const QByteArray& text, int* width = 0);
+};
+
+#endif // CODE128_H
@@ -0,0 +1,202 @@
+#include "connectionpool.h"
+#include "sql.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QSettings>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+class ConnectionPool::Connection
+{
+public:
+    QString name;
+    QElapsedTimer lastUsed;
+
+    explicit Connection(const QString& name)
+        : name(name)
+    {}
+
+    // Runs on the owning thread, when it finishes or releases its connection
+    ~Connection()
+    {
+        if (QSqlDatabase::contains(name))
+            QSqlDatabase::removeDatabase(name);
+        ConnectionPool::instance()->releaseSlot();
+    }
+};
+
+ConnectionPool::Settings::Settings()
+    : driverName("QMYSQL")
+    , port(3306)
+    , maxSize(8)
+    , idleCheckInterval(60)
+    , acquireTimeout(30000)
+    , connectTimeout(5)
+{
+}
+
+ConnectionPool::ConnectionPool()
+    : _size(0)
+    , _serial(0)
+{
+}
+
+ConnectionPool* ConnectionPool::instance()
+{
+    // Never destroyed, thread storage cleanup may still reach it during exit
+    static ConnectionPool* pool = new ConnectionPool;
+    return pool;
+}
+
+ConnectionPool::Settings ConnectionPool::loadSettings(const QString& path)
+{
+    QSettings settings(path, QSettings::IniFormat);
+    Settings result;
+
+    settings.beginGroup("Database");
+    result.driverName = settings.value("driverName", result.driverName).toString();
+    result.hostName = settings.value("hostName").toString();
+    result.port = settings.value("port", result.port).toInt();
+    result.databaseName = settings.value("databaseName").toString();
+    result.userName = settings.value("userName").toString();
+    result.password = settings.value("password").toString();
+    result.connectOptions = settings.value("connectOptions").toString();
+    result.maxSize = qMax(1, settings.value("poolSize", result.maxSize).toInt());
+    result.idleCheckInterval = settings.value("idleCheckInterval", result.idleCheckInterval).toInt();
+    result.acquireTimeout = settings.value("acquireTimeout", result.acquireTimeout).toInt();
+    result.connectTimeout = settings.value("connectTimeout", result.connectTimeout).toInt();
+    settings.endGroup();
+
+    return result;
+}
+
+void ConnectionPool::setSettings(const Settings& settings)
+{
+    QMutexLocker locker(&_mutex);
+    _settings = settings;
+}
+
+ConnectionPool::Settings ConnectionPool::settings() const
+{
+    QMutexLocker locker(&_mutex);
+    return _settings;
+}
+
+QSqlDatabase ConnectionPool::database()
+{
+    Connection* connection = _connections.localData();
+
+    if (!connection) {
+        if (!reserveSlot()) {
+            qDebug() << "SQL ERROR: no free database connection";
+            return QSqlDatabase();
+        }
+
+        Settings settings;
+        QString name;
+        {
+            QMutexLocker locker(&_mutex);
+            settings = _settings;
+            name = QString("ConnectionPool.%1").arg(++_serial);
+        }
+
+        QSqlDatabase db = QSqlDatabase::addDatabase(settings.driverName, name);
+        db.setHostName(settings.hostName);
+        db.setPort(settings.port);
+        db.setDatabaseName(settings.databaseName);
+        db.setUserName(settings.userName);
+        db.setPassword(settings.password);
+
+        // Without a timeout an unreachable server blocks the thread for as long as the OS keeps trying
+        QString connectOptions = settings.connectOptions;
+        if (settings.driverName == "QMYSQL" && settings.connectTimeout > 0
+                && !connectOptions.contains("MYSQL_OPT_CONNECT_TIMEOUT")) {
+            if (!connectOptions.isEmpty())
+                connectOptions += ';';
+            connectOptions += QString("MYSQL_OPT_CONNECT_TIMEOUT=%1").arg(settings.connectTimeout);
+        }
+        db.setConnectOptions(connectOptions);
+
+        connection = new Connection(name);
+        _connections.setLocalData(connection);
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(connection->name, false);
+
+    // The server may have closed a connection that sat idle, ping it before handing it out
+    if (db.isOpen() && connection->lastUsed.isValid()
+            && connection->lastUsed.hasExpired(qint64(settings().idleCheckInterval) * 1000)) {
+        QSqlQuery q(db);
+        if (!Sql::exec(q, "select 1")) {
+            qDebug() << "Reconnecting idle connection" << connection->name << qPrintable(q.lastError().text());
+            db.close();
+        }
+    }
+
+    if (!db.isOpen() && !db.open())
+        qDebug() << "SQL ERROR:" << qPrintable(db.lastError().text());
+
+    connection->lastUsed.start();
+    return db;
+}
+
+void ConnectionPool::release()
+{
+    if (_connections.hasLocalData())
+        _connections.setLocalData(0);
+}
+
+bool ConnectionPool::hasConnection() const
+{
+    return _connections.hasLocalData();
+}
+
+int ConnectionPool::size() const
+{
+    QMutexLocker locker(&_mutex);
+    return _size;
+}
+
+int ConnectionPool::available() const
+{
+    QMutexLocker locker(&_mutex);
+    return qMax(0, _settings.maxSize - _size);
+}
+
+ConnectionPool::Lease::Lease()
+    : _owned(!ConnectionPool::instance()->hasConnection()
+             && !(QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()))
+{
+}
+
+ConnectionPool::Lease::~Lease()
+{
+    if (_owned)
+        ConnectionPool::instance()->release();
+}
+
+bool ConnectionPool::reserveSlot()
+{
+    QMutexLocker locker(&_mutex);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (_size >= _settings.maxSize) {
+        qint64 remaining = _settings.acquireTimeout - timer.elapsed();
+        if (remaining <= 0 || !_slotReleased.wait(&_mutex, quint64(remaining)))
+            return false;
+    }
+
+    _size++;
+    return true;
+}
+
+void ConnectionPool::releaseSlot()
+{
+    QMutexLocker locker(&_mutex);
+    _size--;
+    _slotReleased.wakeOne();
+}
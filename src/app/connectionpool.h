@@ -0,0 +1,92 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QSqlDatabase>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QWaitCondition>
+
+// Hands out one database connection per thread.
+// A QSqlDatabase may only be used by the thread that opened it, so every
+// thread gets its own named connection, opened on first use and removed
+// when the thread finishes, calls release() or its Lease ends. Connections idle for longer
+// than the check interval are pinged before being handed out again and
+// reopened when the server has dropped them.
+class ConnectionPool
+{
+public:
+    struct Settings
+    {
+        QString driverName;
+        QString hostName;
+        int port;
+        QString databaseName;
+        QString userName;
+        QString password;
+        QString connectOptions;
+
+        // Connections open at the same time, threads past this wait for one to be released
+        int maxSize;
+        // Seconds a connection may stay idle before it is checked
+        int idleCheckInterval;
+        // Milliseconds a thread waits for a free slot
+        int acquireTimeout;
+        // Seconds to wait for the server when opening a connection
+        int connectTimeout;
+
+        Settings();
+    };
+
+    static ConnectionPool* instance();
+
+    // Reads the Database group of the settings file
+    static Settings loadSettings(const QString& path);
+
+    void setSettings(const Settings& settings);
+    Settings settings() const;
+
+    // Gives the calling thread's connection back to the pool when it goes out of
+    // scope, so pooled worker threads do not keep a slot while they sit idle.
+    // Nested leases and threads that already held a connection keep it, and the
+    // GUI thread always keeps its own.
+    class Lease
+    {
+    public:
+        Lease();
+        ~Lease();
+
+        QSqlDatabase database() const { return ConnectionPool::instance()->database(); }
+
+    private:
+        Q_DISABLE_COPY(Lease)
+
+        bool _owned;
+    };
+
+    // The connection of the calling thread, invalid when it can not be opened
+    QSqlDatabase database();
+    void release();
+    bool hasConnection() const;
+
+    int size() const;
+    // Slots not taken by any thread right now
+    int available() const;
+
+private:
+    class Connection;
+
+    ConnectionPool();
+    Q_DISABLE_COPY(ConnectionPool)
+
+    bool reserveSlot();
+    void releaseSlot();
+
+    mutable QMutex _mutex;
+    QWaitCondition _slotReleased;
+    Settings _settings;
+    int _size;
+    quint32 _serial;
+    QThreadStorage<Connection*> _connections;
+};
+
+#endif // CONNECTIONPOOL_H
@@ -0,0 +1,378 @@
+#include "costingengine.h"
+#include "connectionpool.h"
+#include "product.h"
+#include "sql.h"
+#include "trace.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+namespace {
+
+typedef QPair<quint16, CostingEngine::State> ProductState;
+
+const int RowsPerStatement = 500;
+
+// Costs are numbers, so they are written into the statement instead of bound
+bool updateProducts(QSqlQuery& q, const QVector<ProductState>& states)
+{
+    for (int first = 0; first < states.size(); first += RowsPerStatement) {
+        int last = qMin(first + RowsPerStatement, states.size());
+
+        QStringList ids;
+        QString averageCase("case id");
+        QString lastCase("case id");
+        for (int i = first; i < last; i++) {
+            const ProductState& state = states.at(i);
+            ids << QString::number(state.first);
+            averageCase += QString(" when %1 then %2").arg(state.first).arg(state.second.averageCost);
+            lastCase += QString(" when %1 then %2").arg(state.first).arg(state.second.lastCost);
+        }
+        averageCase += " end";
+        lastCase += " end";
+
+        // MySQL sees the new column values in later assignments and SQLite does not, so cost repeats the cases
+        QString sql = QString("update products set averageCost=%1, lastPurchaseCost=%2,"
+                              " cost=case costingMethod when %3 then %1 when %4 then %2 else cost end"
+                              " where id in (%5)")
+                .arg(averageCase, lastCase)
+                .arg(int(Product::CostingMethod::Average))
+                .arg(int(Product::CostingMethod::Last))
+                .arg(ids.join(','));
+        if (!Sql::exec(q, sql)) {
+            qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+bool CostingEngine::createTables(QSqlDatabase& db)
+{
+    bool mysql = db.driverName() == "QMYSQL";
+    QString id = mysql ? "id int unsigned not null auto_increment primary key"
+                       : "id integer primary key autoincrement";
+    QString tableOptions = mysql ? " engine=InnoDB default charset=utf8mb4" : "";
+
+    QStringList statements;
+    statements << QString("create table if not exists product_cost_ledger ("
+                          " %1,"
+                          " productId int unsigned not null,"
+                          " quantity bigint not null,"
+                          " unitCost bigint unsigned not null default 0,"
+                          " reference varchar(50) not null default ''"
+                          "%2)%3")
+                  .arg(id, mysql ? ", key product_cost_ledger_productId (productId, id)" : "", tableOptions)
+               << QString("create table if not exists product_costs ("
+                          " productId int unsigned not null primary key,"
+                          " quantity bigint not null default 0,"
+                          " value bigint not null default 0,"
+                          " averageCost bigint unsigned not null default 0,"
+                          " lastCost bigint unsigned not null default 0"
+                          ")%1")
+                  .arg(tableOptions);
+
+    // SQLite has no inline secondary keys
+    if (!mysql)
+        statements << "create index if not exists product_cost_ledger_productId on product_cost_ledger(productId, id)";
+
+    QSqlQuery q(db);
+    for (const QString& statement: statements) {
+        if (!Sql::exec(q, statement)) {
+            qDebug() << "SQL ERROR:" << q.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CostingEngine::post(State* state, qint64 quantity, quint64 unitCost)
+{
+    if (quantity > 0) {
+        if (state->quantity >= 0) {
+            state->value += quantity * qint64(unitCost);
+            state->quantity += quantity;
+            state->averageCost = quint64((state->value + state->quantity / 2) / state->quantity);
+        }
+        else {
+            // The shortfall is covered first, what is left is valued at this receipt's cost
+            state->quantity += quantity;
+            state->value = qMax<qint64>(0, state->quantity) * qint64(unitCost);
+            state->averageCost = unitCost;
+        }
+        state->lastCost = unitCost;
+    }
+    else if (quantity < 0) {
+        qint64 issued = -quantity;
+        if (state->quantity > 0) {
+            qint64 taken = qMin(issued, state->quantity);
+            // The last units take whatever value is left, so rounding never strands any
+            if (taken == state->quantity)
+                state->value = 0;
+            else
+                state->value = qMax<qint64>(0, state->value - taken * qint64(state->averageCost));
+        }
+        state->quantity -= issued;
+    }
+}
+
+bool CostingEngine::postReceipt(quint16 productId, quint64 quantity, quint64 unitCost, const QString& reference)
+{
+    if (!quantity)
+        return false;
+
+    return postEntry(productId, qint64(quantity), unitCost, reference);
+}
+
+bool CostingEngine::postIssue(quint16 productId, quint64 quantity, const QString& reference)
+{
+    if (!quantity)
+        return false;
+
+    return postEntry(productId, -qint64(quantity), 0, reference);
+}
+
+bool CostingEngine::postEntry(quint16 productId, qint64 quantity, quint64 unitCost, const QString& reference)
+{
+    SIMS_TRACE_SCOPE("CostingEngine::postEntry");
+
+    QSqlDatabase db = ConnectionPool::instance()->database();
+    QSqlQuery q(db);
+    bool mysql = db.driverName() == "QMYSQL";
+
+    if (!db.transaction()) {
+        qDebug() << __FILE__ << __LINE__ << db.lastError().text();
+        return false;
+    }
+
+    // The state row has to exist before it can be locked, or two first receipts would both insert it
+    q.prepare(QString("insert %1 into product_costs(productId) values(?)").arg(mysql ? "ignore" : "or ignore"));
+    q.addBindValue(productId);
+    if (!Sql::exec(q)) {
+        qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    q.prepare(QString("select quantity, value, averageCost, lastCost from product_costs where productId=?%1")
+              .arg(mysql ? " for update" : ""));
+    q.addBindValue(productId);
+    if (!Sql::exec(q) || !q.next()) {
+        qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    State state;
+    state.quantity = q.value(0).toLongLong();
+    state.value = q.value(1).toLongLong();
+    state.averageCost = q.value(2).toULongLong();
+    state.lastCost = q.value(3).toULongLong();
+
+    // Issues are recorded at the average they were taken out at
+    quint64 ledgerCost = quantity > 0 ? unitCost : state.averageCost;
+    post(&state, quantity, unitCost);
+
+    q.prepare("insert into product_cost_ledger(productId, quantity, unitCost, reference) values(?,?,?,?)");
+    q.addBindValue(productId);
+    q.addBindValue(quantity);
+    q.addBindValue(ledgerCost);
+    q.addBindValue(reference);
+    if (!Sql::exec(q)) {
+        qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    q.prepare("update product_costs set quantity=?, value=?, averageCost=?, lastCost=? where productId=?");
+    q.addBindValue(state.quantity);
+    q.addBindValue(state.value);
+    q.addBindValue(state.averageCost);
+    q.addBindValue(state.lastCost);
+    q.addBindValue(productId);
+    if (!Sql::exec(q)) {
+        qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    if (!updateProducts(q, QVector<ProductState>() << qMakePair(productId, state))) {
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        qDebug() << __FILE__ << __LINE__ << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
+
+bool CostingEngine::recompute(const ProgressCallback& progress, int threads)
+{
+    SIMS_TRACE_SCOPE("CostingEngine::recompute");
+
+    quint32 maxId = 0;
+    {
+        ConnectionPool::Lease lease;
+        QSqlQuery q(lease.database());
+        if (!Sql::exec(q, "select max(productId) from product_cost_ledger")) {
+            qDebug() << "SQL ERROR:" << q.lastError().text();
+            return false;
+        }
+        if (q.next())
+            maxId = q.value(0).toUInt();
+    }
+    if (!maxId)
+        return true;
+
+    // Other threads keep their connections meanwhile, more workers than free
+    // slots would only wait for one until the pool's timeout and fail
+    threads = qBound(1, threads, qMax(1, ConnectionPool::instance()->available()));
+
+    // A few ranges per thread, so one busy range does not hold up the rest
+    quint32 step = maxId / quint32(threads * 4) + 1;
+
+    const int total = int((maxId + step - 1) / step);
+    QAtomicInt failed(0);
+    QAtomicInt done(0);
+    QAtomicInt next(0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    // Every worker leases one connection and takes ranges until none are left
+    QList<QFuture<void> > futures;
+    for (int i = 0; i < threads; i++) {
+        futures << QtConcurrent::run(&pool, [maxId, step, total, &progress, &failed, &done, &next]() {
+            ConnectionPool::Lease lease;
+            QSqlDatabase db = lease.database();
+            if (!db.isOpen()) {
+                failed.storeRelease(1);
+                return;
+            }
+
+            for (int range = next.fetchAndAddOrdered(1); range < total && !failed.loadAcquire();
+                 range = next.fetchAndAddOrdered(1)) {
+                quint32 first = 1 + quint32(range) * step;
+                quint32 last = qMin(maxId, first + step - 1);
+                if (!recomputeRange(db, first, last)
+                        || (progress && !progress(done.fetchAndAddOrdered(1) + 1, total)))
+                    failed.storeRelease(1);
+            }
+        });
+    }
+
+    for (QFuture<void>& future: futures)
+        future.waitForFinished();
+
+    return !failed.loadAcquire();
+}
+
+bool CostingEngine::recomputeRange(QSqlDatabase& db, quint32 firstId, quint32 lastId)
+{
+    SIMS_TRACE_SCOPE("CostingEngine::recomputeRange");
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+
+    if (!db.transaction()) {
+        qDebug() << __FILE__ << __LINE__ << db.lastError().text();
+        return false;
+    }
+
+    // postEntry() locks a product's state row before it appends to the ledger, so
+    // locking the range first, gaps included, keeps every post either wholly in
+    // the ledger read below or waiting until the rebuilt rows are committed.
+    // SQLite has one writer at a time, a post committed after the read below makes
+    // the delete fail as busy instead.
+    if (db.driverName() == "QMYSQL") {
+        q.prepare("select productId from product_costs where productId between ? and ? for update");
+        q.addBindValue(firstId);
+        q.addBindValue(lastId);
+        if (!Sql::exec(q)) {
+            qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+            db.rollback();
+            return false;
+        }
+        q.finish();
+    }
+
+    q.prepare("select productId, quantity, unitCost from product_cost_ledger"
+              " where productId between ? and ?"
+              " order by productId, id");
+    q.addBindValue(firstId);
+    q.addBindValue(lastId);
+    if (!Sql::exec(q)) {
+        qDebug() << "SQL ERROR:" << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    QVector<ProductState> states;
+    while (q.next()) {
+        quint16 productId = q.value(0).value<quint16>();
+        if (states.isEmpty() || states.last().first != productId)
+            states << qMakePair(productId, State());
+        post(&states.last().second, q.value(1).toLongLong(), q.value(2).toULongLong());
+    }
+    q.finish();
+
+    q.prepare("delete from product_costs where productId between ? and ?");
+    q.addBindValue(firstId);
+    q.addBindValue(lastId);
+    if (!Sql::exec(q)) {
+        qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    for (int first = 0; first < states.size(); first += RowsPerStatement) {
+        int last = qMin(first + RowsPerStatement, states.size());
+
+        QStringList values;
+        for (int i = first; i < last; i++) {
+            const State& state = states.at(i).second;
+            values << QString("(%1,%2,%3,%4,%5)")
+                      .arg(states.at(i).first)
+                      .arg(state.quantity)
+                      .arg(state.value)
+                      .arg(state.averageCost)
+                      .arg(state.lastCost);
+        }
+
+        if (!Sql::exec(q, QString("insert into product_costs(productId, quantity, value, averageCost, lastCost) values %1")
+                       .arg(values.join(',')))) {
+            qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!updateProducts(q, states)) {
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        qDebug() << __FILE__ << __LINE__ << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
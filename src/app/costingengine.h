@@ -0,0 +1,55 @@
+#ifndef COSTINGENGINE_H
+#define COSTINGENGINE_H
+
+#include <QString>
+#include <QThread>
+#include <functional>
+
+class QSqlDatabase;
+
+// Keeps averageCost, lastPurchaseCost and cost of products up to date.
+// Every receipt and issue is appended to product_cost_ledger and folded
+// into the product's row in product_costs, so posting costs the same no
+// matter how long the ledger grows. recompute() rebuilds product_costs
+// from the whole ledger when the two ever disagree.
+class CostingEngine
+{
+public:
+    struct State
+    {
+        // Negative when more was issued than received
+        qint64 quantity;
+        // Value of the stock on hand, whole rupiah
+        qint64 value;
+        quint64 averageCost;
+        quint64 lastCost;
+
+        State() : quantity(0), value(0), averageCost(0), lastCost(0) {}
+    };
+
+    // Moving weighted average: receipts (positive quantity) blend their cost in,
+    // issues (negative quantity) take stock out at the current average
+    static void post(State* state, qint64 quantity, quint64 unitCost);
+
+    static bool postReceipt(quint16 productId, quint64 quantity, quint64 unitCost, const QString& reference = QString());
+    static bool postIssue(quint16 productId, quint64 quantity, const QString& reference = QString());
+
+    // product_cost_ledger and product_costs, when they are not there yet.
+    // Called on every connect, so existing databases get them on the next start.
+    static bool createTables(QSqlDatabase& db);
+
+    // Called from the worker threads as id ranges finish, returning false cancels.
+    // Ranges already done stay recomputed, each one commits on its own.
+    typedef std::function<bool(int done, int total)> ProgressCallback;
+
+    // Replays the ledger over product id ranges on several threads, each with its own
+    // connection, never more threads than the ConnectionPool has free slots
+    static bool recompute(const ProgressCallback& progress = ProgressCallback(),
+                          int threads = QThread::idealThreadCount());
+
+private:
+    static bool postEntry(quint16 productId, qint64 quantity, quint64 unitCost, const QString& reference);
+    static bool recomputeRange(QSqlDatabase& db, quint32 firstId, quint32 lastId);
+};
+
+#endif // COSTINGENGINE_H
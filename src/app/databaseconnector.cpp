@@ -0,0 +1,91 @@
+#include "databaseconnector.h"
+#include "connectionpool.h"
+#include "costingengine.h"
+#include "global.h"
+#include "trace.h"
+
+#include <QSettings>
+#include <QTimer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QDebug>
+
+#include <QtConcurrentRun>
+
+DatabaseConnector::DatabaseConnector(QObject* parent)
+    : QObject(parent)
+    , _attempt(0)
+    , _ready(false)
+{
+    QSettings settings(SIMS_DEFAULT_SETTINGS_PATH, QSettings::IniFormat);
+    _maxAttempts = qMax(1, settings.value("Database/connectAttempts", 3).toInt());
+    _retryDelay = settings.value("Database/connectRetryDelay", 2000).toInt();
+
+    _pool.setMaxThreadCount(1);
+
+    connect(&_watcher, SIGNAL(finished()), SLOT(_onAttemptFinished()));
+}
+
+DatabaseConnector::~DatabaseConnector()
+{
+    _pool.waitForDone();
+}
+
+void DatabaseConnector::start()
+{
+    if (_ready || _watcher.isRunning())
+        return;
+
+    _attempt = 0;
+    _timer.start();
+    _tryConnect();
+}
+
+void DatabaseConnector::_tryConnect()
+{
+    _attempt++;
+    emit connecting(_attempt);
+    _watcher.setFuture(QtConcurrent::run(&_pool, &DatabaseConnector::probe));
+}
+
+void DatabaseConnector::_onAttemptFinished()
+{
+    QString error = _watcher.result();
+
+    if (error.isEmpty()) {
+        _ready = true;
+        if (Trace::isEnabled()) {
+            qint64 duration = _timer.nsecsElapsed() / 1000;
+            Trace::record("DatabaseConnector::connect", "startup", qMax<qint64>(0, Trace::now() - duration), duration,
+                          QString("%1 attempt(s)").arg(_attempt));
+        }
+        emit ready();
+        return;
+    }
+
+    qWarning() << "Database connection attempt" << _attempt << "failed:" << qPrintable(error);
+
+    if (_attempt < _maxAttempts) {
+        QTimer::singleShot(_retryDelay, this, SLOT(_tryConnect()));
+        return;
+    }
+
+    emit failed(error);
+}
+
+// Runs on the connector's own thread, the probe connection is handed back to the pool right away
+QString DatabaseConnector::probe()
+{
+    QString error;
+    {
+        QSqlDatabase db = ConnectionPool::instance()->database();
+        if (!db.isOpen())
+            error = db.lastError().text().isEmpty() ? QString("Tidak dapat terhubung ke server") : db.lastError().text();
+        // Only the costing features need these, a user without create rights can still work
+        else if (!CostingEngine::createTables(db))
+            qWarning() << "Costing tables could not be created, recomputing costs will fail";
+    }
+
+    ConnectionPool::instance()->release();
+    return error;
+}
@@ -0,0 +1,46 @@
+#ifndef DATABASECONNECTOR_H
+#define DATABASECONNECTOR_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+
+// Opens the first database connection away from the GUI thread.
+// Failed attempts are retried after a delay, ready() or failed() tells
+// the outcome. Widgets that need the database wait for ready().
+class DatabaseConnector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DatabaseConnector(QObject* parent = 0);
+    ~DatabaseConnector();
+
+    bool isReady() const { return _ready; }
+
+signals:
+    void connecting(int attempt);
+    void ready();
+    void failed(const QString& error);
+
+public slots:
+    void start();
+
+private slots:
+    void _tryConnect();
+    void _onAttemptFinished();
+
+private:
+    static QString probe();
+
+    QThreadPool _pool;
+    QFutureWatcher<QString> _watcher;
+    QElapsedTimer _timer;
+    int _attempt;
+    int _maxAttempts;
+    int _retryDelay;
+    bool _ready;
+};
+
+#endif // DATABASECONNECTOR_H
@@ -0,0 +1,84 @@
+#include "labeldialog.h"
+
+#include <QComboBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QBoxLayout>
+#include <QLocale>
+
+LabelDialog::LabelDialog(int productCount, QWidget *parent)
+    : QDialog(parent)
+    , _productCount(productCount)
+    , _sheets(LabelPrinter::sheets())
+{
+    setWindowTitle("Cetak Label");
+
+    _sheetComboBox = new QComboBox(this);
+    for (const LabelPrinter::Sheet& sheet: _sheets)
+        _sheetComboBox->addItem(sheet.name);
+
+    _copiesSpinBox = new QSpinBox(this);
+    _copiesSpinBox->setRange(1, 999);
+
+    _skipSpinBox = new QSpinBox(this);
+
+    _destinationComboBox = new QComboBox(this);
+    _destinationComboBox->addItem("Printer", Printer);
+    _destinationComboBox->addItem("File PDF", Pdf);
+
+    _summaryLabel = new QLabel(this);
+
+    connect(_sheetComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onInputChanged()));
+    connect(_copiesSpinBox, SIGNAL(valueChanged(int)), SLOT(_onInputChanged()));
+    connect(_skipSpinBox, SIGNAL(valueChanged(int)), SLOT(_onInputChanged()));
+
+    QFormLayout* formLayout = new QFormLayout;
+    formLayout->addRow("Lembar label:", _sheetComboBox);
+    formLayout->addRow("Jumlah per produk:", _copiesSpinBox);
+    formLayout->addRow("Lewati label:", _skipSpinBox);
+    formLayout->addRow("Tujuan:", _destinationComboBox);
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(this);
+    buttonBox->addButton("&Cetak", QDialogButtonBox::AcceptRole);
+    buttonBox->addButton("&Batal", QDialogButtonBox::RejectRole);
+    connect(buttonBox, SIGNAL(accepted()), SLOT(accept()));
+    connect(buttonBox, SIGNAL(rejected()), SLOT(reject()));
+
+    QBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addWidget(_summaryLabel);
+    mainLayout->addWidget(buttonBox);
+
+    _onInputChanged();
+}
+
+LabelPrinter::Options LabelDialog::options() const
+{
+    LabelPrinter::Options options;
+    options.sheet = _sheets.at(_sheetComboBox->currentIndex());
+    options.copies = _copiesSpinBox->value();
+    options.skip = _skipSpinBox->value();
+    return options;
+}
+
+LabelDialog::Destination LabelDialog::destination() const
+{
+    return Destination(_destinationComboBox->currentData().toInt());
+}
+
+void LabelDialog::_onInputChanged()
+{
+    LabelPrinter::Options options = this->options();
+    int perSheet = options.sheet.labelCount();
+    _skipSpinBox->setRange(0, perSheet - 1);
+
+    int labels = _productCount * options.copies;
+    int sheets = (labels + options.skip + perSheet - 1) / perSheet;
+    QLocale locale;
+    _summaryLabel->setText(QString("%1 produk, %2 label pada %3 lembar.")
+                           .arg(locale.toString(_productCount))
+                           .arg(locale.toString(labels))
+                           .arg(locale.toString(sheets)));
+}
@@ -0,0 +1,38 @@
+#ifndef LABELDIALOG_H
+#define LABELDIALOG_H
+
+#include "labelprinter.h"
+
+#include <QDialog>
+
+class QComboBox;
+class QSpinBox;
+class QLabel;
+
+// Asks for the label stock, copies and destination before printing labels
+class LabelDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    enum Destination { Printer, Pdf };
+
+    LabelDialog(int productCount, QWidget *parent = 0);
+
+    LabelPrinter::Options options() const;
+    Destination destination() const;
+
+private slots:
+    void _onInputChanged();
+
+private:
+    int _productCount;
+    QVector<LabelPrinter::Sheet> _sheets;
+    QComboBox* _sheetComboBox;
+    QSpinBox* _copiesSpinBox;
+    QSpinBox* _skipSpinBox;
+    QComboBox* _destinationComboBox;
+    QLabel* _summaryLabel;
+};
+
+#endif // LABELDIALOG_H
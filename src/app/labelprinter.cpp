@@ -0,0 +1,273 @@
+#include "labelprinter.h"
+#include "pagespooler.h"
+#include "pricebook.h"
+#include "code128.h"
+#include "connectionpool.h"
+#include "product.h"
+#include "sql.h"
+#include "trace.h"
+
+#include <QPdfWriter>
+#include <QPainter>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QHash>
+#include <QFile>
+#include <QLocale>
+#include <QtConcurrentMap>
+
+namespace {
+
+// Layout units are points, the painter scales them to the device
+const qreal Millimeter = 72 / 25.4;
+const int IdsPerStatement = 1000;
+
+struct Label
+{
+    quint16 id;
+    QString name;
+    QString baseUom;
+    bool hasPrice;
+    quint64 price;
+    int modules;
+    QVector<Code128::Bar> bars;
+};
+
+struct Page
+{
+    // Labels fill the sheet from this slot on, row by row
+    int firstSlot;
+    QVector<Label> labels;
+};
+
+QRectF slotRect(const LabelPrinter::Sheet& sheet, int slot)
+{
+    int column = slot % sheet.columns;
+    int row = slot / sheet.columns;
+    return QRectF((sheet.left + column * (sheet.labelWidth + sheet.horizontalGap)) * Millimeter,
+                  (sheet.top + row * (sheet.labelHeight + sheet.verticalGap)) * Millimeter,
+                  sheet.labelWidth * Millimeter, sheet.labelHeight * Millimeter);
+}
+
+void paintLabel(QPainter* painter, const QRectF& rect, const Label& label, const QLocale& locale)
+{
+    const qreal padding = 1.5 * Millimeter;
+    const QRectF inner = rect.adjusted(padding, padding, -padding, -padding);
+
+    // Name on top, the price under it and the barcode in the rest
+    const qreal nameHeight = inner.height() * 0.3;
+    const qreal priceHeight = inner.height() * 0.28;
+    const qreal codeHeight = qBound(4.0, inner.height() * 0.1, 7.0);
+    const qreal barsHeight = inner.height() - nameHeight - priceHeight - codeHeight;
+
+    QFont nameFont;
+    nameFont.setPixelSize(qBound(5, int(nameHeight / 2.4), 9));
+    painter->setFont(nameFont);
+    painter->setPen(Qt::black);
+    painter->drawText(QRectF(inner.left(), inner.top(), inner.width(), nameHeight),
+                      Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, label.name);
+
+    QRectF priceRect(inner.left(), inner.top() + nameHeight, inner.width(), priceHeight);
+    QFont priceFont;
+    priceFont.setPixelSize(qMax(6, int(priceHeight * 0.8)));
+    priceFont.setBold(true);
+    painter->setFont(priceFont);
+    painter->drawText(priceRect, Qt::AlignLeft | Qt::AlignVCenter,
+                      label.hasPrice ? QString("Rp %1").arg(locale.toString(label.price)) : "-");
+
+    QFont uomFont;
+    uomFont.setPixelSize(qBound(5, int(priceHeight * 0.4), 8));
+    painter->setFont(uomFont);
+    painter->drawText(priceRect, Qt::AlignRight | Qt::AlignBottom, "/ " + label.baseUom);
+
+    const QString code = Product::formatCode(label.id);
+    const qreal barsTop = priceRect.bottom();
+    if (!label.bars.isEmpty()) {
+        const qreal moduleWidth = inner.width() / (label.modules + 2 * Code128::QuietZone);
+        const qreal x = inner.center().x() - label.modules * moduleWidth / 2;
+
+        // Blurred edges only make bars harder to scan
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        for (const Code128::Bar& bar: label.bars)
+            painter->fillRect(QRectF(x + bar.start * moduleWidth, barsTop, bar.width * moduleWidth, barsHeight), Qt::black);
+        painter->setRenderHint(QPainter::Antialiasing);
+    }
+
+    QFont codeFont;
+    codeFont.setPixelSize(qMax(4, int(codeHeight)));
+    painter->setFont(codeFont);
+    painter->drawText(QRectF(inner.left(), barsTop + barsHeight, inner.width(), codeHeight),
+                      Qt::AlignHCenter | Qt::AlignVCenter, code);
+}
+
+void paintPage(QPainter* painter, const Page& page, const LabelPrinter::Sheet& sheet)
+{
+    QLocale locale;
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setRenderHint(QPainter::TextAntialiasing);
+
+    for (int i = 0; i < page.labels.size(); i++) {
+        QRectF rect = slotRect(sheet, page.firstSlot + i);
+        painter->save();
+        painter->setClipRect(rect);
+        paintLabel(painter, rect, page.labels.at(i), locale);
+        painter->restore();
+    }
+}
+
+// Names from one query per thousand products, prices read fresh into the shared PriceBook
+bool loadLabels(const QVector<quint16>& productIds, QVector<Label>* labels, QString* error)
+{
+    SIMS_TRACE_SCOPE("LabelPrinter::loadLabels");
+
+    ConnectionPool::Lease lease;
+
+    // Prices may have changed on another workstation since they were cached
+    if (!PriceBook::instance()->reload(productIds)) {
+        *error = "Harga produk gagal dimuat.";
+        return false;
+    }
+
+    QHash<quint16, QPair<QString, QString> > products;
+    products.reserve(productIds.size());
+    QSqlQuery q(lease.database());
+    q.setForwardOnly(true);
+    for (int first = 0; first < productIds.size(); first += IdsPerStatement) {
+        // Ids are numbers, so they go into the statement instead of thousands of bind values
+        QStringList ids;
+        for (quint16 id: productIds.mid(first, IdsPerStatement))
+            ids << QString::number(id);
+
+        if (!Sql::exec(q, QString("select id, name, baseUom from products where id in (%1)").arg(ids.join(',')))) {
+            *error = q.lastError().text();
+            return false;
+        }
+        while (q.next())
+            products.insert(q.value(0).value<quint16>(), qMakePair(q.value(1).toString(), q.value(2).toString()));
+        q.finish();
+    }
+
+    labels->clear();
+    labels->reserve(productIds.size());
+    for (quint16 id: productIds) {
+        if (!products.contains(id))
+            continue;
+
+        Label label;
+        label.id = id;
+        label.name = products.value(id).first;
+        label.baseUom = products.value(id).second;
+        label.price = 0;
+        label.hasPrice = PriceBook::instance()->table(id).price(1, 1, &label.price);
+        label.modules = 0;
+        *labels << label;
+    }
+
+    QtConcurrent::blockingMap(*labels, [](Label& label) {
+        label.bars = Code128::bars(Product::formatCode(label.id).toLatin1(), &label.modules);
+    });
+
+    return true;
+}
+
+}
+
+QVector<LabelPrinter::Sheet> LabelPrinter::sheets()
+{
+    const Sheet sheets[] = {
+        { "A4, 3 x 8 (70 x 37 mm)", QPageSize::A4, 3, 8, 70, 37, 0, 0.5, 0, 0 },
+        { "A4, 4 x 10 (48,5 x 25,4 mm)", QPageSize::A4, 4, 10, 48.5, 25.4, 8, 21.5, 0, 0 },
+        { "A4, 2 x 7 (99,1 x 38,1 mm)", QPageSize::A4, 2, 7, 99.1, 38.1, 4.65, 15.15, 2.5, 0 },
+        { "Letter, 3 x 10 (66,7 x 25,4 mm)", QPageSize::Letter, 3, 10, 66.7, 25.4, 4.8, 12.7, 3.1, 0 },
+    };
+    QVector<Sheet> result;
+    for (const Sheet& sheet: sheets)
+        result << sheet;
+    return result;
+}
+
+bool LabelPrinter::print(QPagedPaintDevice* device, bool raster, const Options& options,
+                         const QVector<quint16>& productIds, const ProgressCallback& progress, QString* error)
+{
+    SIMS_TRACE_SCOPE("LabelPrinter::print");
+
+    auto fail = [error](const QString& text) {
+        if (error)
+            *error = text;
+        return false;
+    };
+
+    const Sheet sheet = options.sheet;
+    const int copies = qMax(1, options.copies);
+    const int perSheet = sheet.labelCount();
+    if (perSheet <= 0)
+        return fail("Ukuran lembar label tidak valid.");
+
+    QVector<Label> labels;
+    QString loadError;
+    if (!loadLabels(productIds, &labels, &loadError))
+        return fail(loadError);
+    if (labels.isEmpty())
+        return fail("Produk tidak ditemukan.");
+
+    PageSpooler spooler(device, raster);
+    if (!spooler.begin())
+        return fail("Printer tidak dapat digunakan.");
+
+    auto abort = [&spooler, &fail](const QString& text) {
+        spooler.abort();
+        return fail(text);
+    };
+
+    const int total = labels.size() * copies;
+    const int batchSize = spooler.batchSize();
+    int done = 0;
+    int slot = qBound(0, options.skip, perSheet - 1);
+
+    QVector<PageSpooler::PagePainter> pending;
+    Page current;
+    current.firstSlot = slot;
+
+    for (int i = 0; i < total; i++) {
+        current.labels << labels.at(i / copies);
+        if (++slot < perSheet && i + 1 < total)
+            continue;
+
+        pending << [current, sheet](QPainter* painter) { paintPage(painter, current, sheet); };
+        done += current.labels.size();
+        current.labels.clear();
+        current.firstSlot = 0;
+        slot = 0;
+
+        if (pending.size() >= batchSize || done == total) {
+            spooler.spool(pending);
+            pending.clear();
+            if (progress && !progress(done, total))
+                return abort("Pencetakan dibatalkan.");
+        }
+    }
+
+    if (!spooler.end())
+        return fail("Halaman gagal dikirim ke printer.");
+
+    return true;
+}
+
+bool LabelPrinter::printToPdf(const QString& path, const Options& options,
+                              const QVector<quint16>& productIds, const ProgressCallback& progress, QString* error)
+{
+    bool ok;
+    {
+        QPdfWriter writer(path);
+        writer.setTitle("Label Harga");
+        writer.setPageSize(QPageSize(options.sheet.pageSize));
+        writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+        ok = print(&writer, false, options, productIds, progress, error);
+    }
+
+    if (!ok)
+        QFile::remove(path);
+
+    return ok;
+}
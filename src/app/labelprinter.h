@@ -0,0 +1,64 @@
+#ifndef LABELPRINTER_H
+#define LABELPRINTER_H
+
+#include <QString>
+#include <QVector>
+#include <QPageSize>
+#include <functional>
+
+class QPagedPaintDevice;
+
+// Prints shelf labels on sheets of sticker paper: product name, the
+// level 1 price of a single item and the product code as a Code 128
+// barcode. Sheets are drawn in parallel batches through a PageSpooler.
+// Call from a worker thread, it blocks until the last sheet is out.
+class LabelPrinter
+{
+public:
+    // Label positions are measured from the edge of the paper, in millimeters
+    struct Sheet
+    {
+        QString name;
+        QPageSize::PageSizeId pageSize;
+        int columns;
+        int rows;
+        qreal labelWidth;
+        qreal labelHeight;
+        qreal left;
+        qreal top;
+        qreal horizontalGap;
+        qreal verticalGap;
+
+        int labelCount() const { return columns * rows; }
+    };
+
+    struct Options
+    {
+        Sheet sheet;
+        // Labels per product
+        int copies;
+        // Labels already used on the first sheet
+        int skip;
+
+        Options() : copies(1), skip(0) {}
+    };
+
+    // Called after every batch of sheets, returning false cancels
+    typedef std::function<bool(int done, int total)> ProgressCallback;
+
+    // Common label stock, the first one is the default
+    static QVector<Sheet> sheets();
+
+    // The device must print on the full page, the sheet's margins already
+    // account for the edges. Products are printed in the given order.
+    static bool print(QPagedPaintDevice* device, bool raster, const Options& options,
+                      const QVector<quint16>& productIds,
+                      const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+
+    // Vector pages, the file is removed again when printing fails
+    static bool printToPdf(const QString& path, const Options& options,
+                           const QVector<quint16>& productIds,
+                           const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+};
+
+#endif // LABELPRINTER_H
@@ -3,16 +3,20 @@
 #include <QBuffer>
 #include <QFile>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QSettings>
-#include <QSqlDatabase>
-#include <QSqlError>
-#include <QSqlQuery>
 
 #include "global.h"
+#include "connectionpool.h"
+#include "trace.h"
+#include "sqlstats.h"
 #include "mainwindow.h"
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QApplication app(argc, argv);
 
     QLocale::setDefault(QLocale(QLocale::Indonesian, QLocale::Indonesia));
@@ -56,22 +60,41 @@ int main(int argc, char **argv)
         appPidSharedMemory.unlock();
     }
 
+    // SIMS_TRACE=<file>, or Trace/enabled in the settings file, records a timeline written at exit and on Ctrl+Alt+T.
+    // SIMS_SQL_STATS=1, or Sql/reportAtExit, prints the query statistics at exit.
+    bool sqlReport = false;
     {
         QSettings settings(SIMS_DEFAULT_SETTINGS_PATH, QSettings::IniFormat);
-        QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL");
-        db.setHostName(settings.value("Database/hostName").toString());
-        db.setPort(settings.value("Database/port").toInt());
-        db.setDatabaseName(settings.value("Database/databaseName").toString());
-        db.setUserName(settings.value("Database/userName").toString());
-        db.setPassword(settings.value("Database/password").toString());
-        if (!db.open()) {
-            qCritical() << "Database connection failed:" << qPrintable(db.lastError().text());
-            return 2;
+        QString tracePath = QString::fromLocal8Bit(qgetenv("SIMS_TRACE"));
+        if (tracePath.isEmpty() && settings.value("Trace/enabled", false).toBool())
+            tracePath = settings.value("Trace/path", "shift-ims-trace.json").toString();
+        if (!tracePath.isEmpty()) {
+            Trace::setOutputPath(tracePath);
+            Trace::setEnabled(true);
         }
+
+        sqlReport = !qgetenv("SIMS_SQL_STATS").isEmpty() || settings.value("Sql/reportAtExit", false).toBool();
+        SqlStats::setSlowQueryThreshold(settings.value("Sql/slowQueryThreshold", SqlStats::slowQueryThreshold()).toInt());
     }
 
+    // The connection itself is opened by the main window in the background
+    ConnectionPool::instance()->setSettings(ConnectionPool::loadSettings(SIMS_DEFAULT_SETTINGS_PATH));
+
     MainWindow mw;
     mw.showMaximized();
+    // On the trace timeline only, the span starts at the top of main()
+    if (Trace::isEnabled()) {
+        qint64 duration = startupTimer.nsecsElapsed() / 1000;
+        Trace::record("Startup::showMainWindow", "startup", qMax<qint64>(0, Trace::now() - duration), duration);
+    }
+
+    int status = app.exec();
+
+    if (Trace::isEnabled())
+        Trace::writeChromeTrace();
+
+    if (sqlReport && SqlStats::overall().count)
+        qDebug().noquote() << "SQL statistics:\n" + SqlStats::report();
 
-    return app.exec();
+    return status;
 }
@@ -1,10 +1,22 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "productmanagerwidget.h"
+#include "databaseconnector.h"
+#include "trace.h"
+#include "sqlstats.h"
+#include "costingengine.h"
+#include "backgroundjobdialog.h"
+
+#include <QMessageBox>
+#include <QApplication>
+#include <QAction>
+#include <QLabel>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , _databaseReady(false)
     , _productManagerWidget(nullptr)
 {
     ui->setupUi(this);
@@ -17,6 +29,31 @@ MainWindow::MainWindow(QWidget *parent)
     setCentralWidget(_tabWidget);
 
     connect(ui->manageProductsAction, SIGNAL(triggered(bool)), SLOT(showProductManager()));
+    connect(ui->recomputeCostsAction, SIGNAL(triggered(bool)), SLOT(recomputeCosts()));
+
+    if (Trace::isEnabled()) {
+        QAction* saveTraceAction = new QAction(this);
+        saveTraceAction->setShortcut(QKeySequence("Ctrl+Alt+T"));
+        connect(saveTraceAction, SIGNAL(triggered(bool)), SLOT(saveTrace()));
+        addAction(saveTraceAction);
+    }
+
+    // Live query statistics, the tooltip lists the statements that took the most time
+    _sqlStatusLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(_sqlStatusLabel);
+    QTimer* sqlStatusTimer = new QTimer(this);
+    connect(sqlStatusTimer, SIGNAL(timeout()), SLOT(_updateSqlStatus()));
+    sqlStatusTimer->start(1000);
+
+    // The window comes up right away. The product list shows its snapshot meanwhile,
+    // everything that changes data waits for the connection.
+    ui->recomputeCostsAction->setEnabled(false);
+
+    _databaseConnector = new DatabaseConnector(this);
+    connect(_databaseConnector, SIGNAL(connecting(int)), SLOT(_onDatabaseConnecting(int)));
+    connect(_databaseConnector, SIGNAL(ready()), SLOT(_onDatabaseReady()));
+    connect(_databaseConnector, SIGNAL(failed(QString)), SLOT(_onDatabaseFailed(QString)));
+    _databaseConnector->start();
 }
 
 MainWindow::~MainWindow()
@@ -51,4 +88,82 @@ void MainWindow::closeAllTabs()
 void MainWindow::showProductManager()
 {
     _initTab<ProductManagerWidget>(&_productManagerWidget);
+    _productManagerWidget->setReadOnly(!_databaseReady);
+}
+
+void MainWindow::saveTrace()
+{
+    if (Trace::writeChromeTrace())
+        ui->statusbar->showMessage(QString("Trace disimpan ke %1").arg(Trace::outputPath()), 5000);
+    else
+        ui->statusbar->showMessage("Trace gagal disimpan", 5000);
+}
+
+void MainWindow::recomputeCosts()
+{
+    if (QMessageBox::question(0, "Konfirmasi", "Hitung ulang harga beli semua produk dari riwayat pembelian?", "&Ya", "&Tidak"))
+        return;
+
+    BackgroundJobDialog dialog("Hitung Ulang Harga Beli", "Menghitung %1 dari %2 kelompok produk...",
+                               [](const BackgroundJobDialog::ProgressCallback& progress, QString*) {
+        return CostingEngine::recompute(progress);
+    }, this);
+
+    if (dialog.exec() == QDialog::Accepted)
+        ui->statusbar->showMessage("Harga beli selesai dihitung ulang", 5000);
+    else if (dialog.wasCanceled())
+        ui->statusbar->showMessage("Hitung ulang dibatalkan, sebagian produk sudah dihitung ulang", 5000);
+    else
+        QMessageBox::warning(0, "Peringatan", "Gagal menghitung ulang harga beli!");
+}
+
+void MainWindow::_onDatabaseConnecting(int attempt)
+{
+    if (attempt == 1)
+        ui->statusbar->showMessage("Menghubungkan ke database...");
+    else
+        ui->statusbar->showMessage(QString("Menghubungkan ke database (percobaan ke-%1)...").arg(attempt));
+}
+
+void MainWindow::_onDatabaseReady()
+{
+    ui->statusbar->clearMessage();
+    _databaseReady = true;
+    ui->recomputeCostsAction->setEnabled(true);
+    if (_productManagerWidget)
+        _productManagerWidget->setReadOnly(false);
+}
+
+void MainWindow::_onDatabaseFailed(const QString& error)
+{
+    ui->statusbar->showMessage("Tidak terhubung ke database");
+
+    if (QMessageBox::question(this, "Koneksi Gagal",
+                              QString("Tidak dapat terhubung ke database:\n%1\n\nCoba lagi?").arg(error),
+                              "&Ya", "&Tidak")) {
+        qApp->exit(2);
+        return;
+    }
+
+    _databaseConnector->start();
+}
+
+void MainWindow::_updateSqlStatus()
+{
+    SqlStats::Summary summary = SqlStats::overall();
+    if (!summary.count)
+        return;
+
+    _sqlStatusLabel->setText(QString("SQL: %1 query | p50 %2 ms | p95 %3 ms | p99 %4 ms | lambat %5 | error %6")
+                             .arg(summary.count)
+                             .arg(summary.p50 / 1000.0, 0, 'f', 1)
+                             .arg(summary.p95 / 1000.0, 0, 'f', 1)
+                             .arg(summary.p99 / 1000.0, 0, 'f', 1)
+                             .arg(SqlStats::slowQueryCount())
+                             .arg(summary.errors));
+
+    if (_sqlStatusLabel->underMouse())
+        return;
+
+    _sqlStatusLabel->setToolTip("<pre>" + SqlStats::report(10).toHtmlEscaped() + "</pre>");
 }
@@ -8,6 +8,8 @@ class MainWindow;
 }
 
 class ProductManagerWidget;
+class DatabaseConnector;
+class QLabel;
 
 class MainWindow : public QMainWindow
 {
@@ -21,6 +23,14 @@ public slots:
     void showProductManager();
     bool closeTab(int index);
     void closeAllTabs();
+    void saveTrace();
+    void recomputeCosts();
+
+private slots:
+    void _onDatabaseConnecting(int attempt);
+    void _onDatabaseReady();
+    void _onDatabaseFailed(const QString& error);
+    void _updateSqlStatus();
 
 private:
     template <typename T> void _initTab(T** widget) {
@@ -39,6 +49,9 @@ private:
 private:
     Ui::MainWindow *ui;
     QTabWidget *_tabWidget;
+    DatabaseConnector *_databaseConnector;
+    QLabel *_sqlStatusLabel;
+    bool _databaseReady;
 
     ProductManagerWidget *_productManagerWidget;
 };
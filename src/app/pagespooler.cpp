@@ -0,0 +1,99 @@
+#include "pagespooler.h"
+#include "trace.h"
+
+#include <QPagedPaintDevice>
+#include <QPrinter>
+#include <QPicture>
+#include <QImage>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtMath>
+
+namespace {
+
+// Images past this are only bigger, not sharper on paper
+const int MaxRasterResolution = 300;
+
+}
+
+PageSpooler::PageSpooler(QPagedPaintDevice* device, bool raster)
+    : _device(device)
+    , _raster(raster)
+    , _firstPage(true)
+{
+    _pageSize = QSizeF(device->width() * 72.0 / device->logicalDpiX(), device->height() * 72.0 / device->logicalDpiY());
+    _resolution = qMin(device->logicalDpiX(), MaxRasterResolution);
+    _imageSize = QSize(qCeil(_pageSize.width() * _resolution / 72.0), qCeil(_pageSize.height() * _resolution / 72.0));
+}
+
+bool PageSpooler::begin()
+{
+    _firstPage = true;
+    return _painter.begin(_device);
+}
+
+void PageSpooler::abort()
+{
+    if (QPrinter* printer = dynamic_cast<QPrinter*>(_device))
+        printer->abort();
+    _painter.end();
+}
+
+bool PageSpooler::end()
+{
+    return _painter.end();
+}
+
+int PageSpooler::batchSize() const
+{
+    return qMax(2, QThread::idealThreadCount() * (_raster ? 1 : 4));
+}
+
+void PageSpooler::spool(const QVector<PagePainter>& pages)
+{
+    SIMS_TRACE_SCOPE("PageSpooler::spool");
+
+    if (_raster) {
+        const QSize imageSize = _imageSize;
+        const int resolution = _resolution;
+        std::function<QImage(const PagePainter&)> render = [imageSize, resolution](const PagePainter& paint) {
+            // 16 bit pixels are plenty for black text and halve the memory of a batch
+            QImage image(imageSize, QImage::Format_RGB16);
+            image.fill(Qt::white);
+            QPainter imagePainter(&image);
+            imagePainter.scale(resolution / 72.0, resolution / 72.0);
+            paint(&imagePainter);
+            return image;
+        };
+        QVector<QImage> images = QtConcurrent::blockingMapped<QVector<QImage> >(pages, render);
+
+        const QRectF deviceRect(0, 0, _device->width(), _device->height());
+        for (const QImage& image: images) {
+            if (!_firstPage)
+                _device->newPage();
+            _firstPage = false;
+            _painter.drawImage(deviceRect, image);
+        }
+    }
+    else {
+        std::function<QPicture(const PagePainter&)> render = [](const PagePainter& paint) {
+            QPicture picture;
+            QPainter picturePainter(&picture);
+            paint(&picturePainter);
+            picturePainter.end();
+            return picture;
+        };
+        QVector<QPicture> pictures = QtConcurrent::blockingMapped<QVector<QPicture> >(pages, render);
+
+        const qreal deviceScale = _device->logicalDpiX() / 72.0;
+        for (const QPicture& picture: pictures) {
+            if (!_firstPage)
+                _device->newPage();
+            _firstPage = false;
+            _painter.save();
+            _painter.scale(deviceScale, deviceScale);
+            _painter.drawPicture(QPointF(0, 0), picture);
+            _painter.restore();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef PAGESPOOLER_H
+#define PAGESPOOLER_H
+
+#include <QPainter>
+#include <QSize>
+#include <QSizeF>
+#include <QVector>
+#include <functional>
+
+class QPagedPaintDevice;
+
+// Draws batches of pages on the global thread pool and sends them to a
+// paged device in order. Pages are painted in points from the top left of
+// the device's page area. Raster pages are drawn as images, for printers
+// that rasterize anyway; vector pages keep text as text, for PDF.
+class PageSpooler
+{
+public:
+    typedef std::function<void(QPainter* painter)> PagePainter;
+
+    PageSpooler(QPagedPaintDevice* device, bool raster);
+
+    bool begin();
+    // Cancels a printer job and closes the painter
+    void abort();
+    // False when the device could not take the last pages
+    bool end();
+
+    // In points
+    QSizeF pageSize() const { return _pageSize; }
+
+    // Enough pages to keep every thread busy, few enough that raster batches stay small
+    int batchSize() const;
+
+    void spool(const QVector<PagePainter>& pages);
+
+private:
+    QPagedPaintDevice* _device;
+    bool _raster;
+    bool _firstPage;
+    QPainter _painter;
+    QSizeF _pageSize;
+    int _resolution;
+    QSize _imageSize;
+};
+
+#endif // PAGESPOOLER_H
@@ -0,0 +1,175 @@
+#include "pricebook.h"
+#include "connectionpool.h"
+#include "sql.h"
+#include "trace.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+#include <algorithm>
+
+PriceBook::PriceBook()
+    : _generation(0)
+    , _clearedAt(0)
+{
+}
+
+PriceBook* PriceBook::instance()
+{
+    static PriceBook book;
+    return &book;
+}
+
+bool PriceBook::load(const QVector<quint16>& productIds)
+{
+    SIMS_TRACE_SCOPE("PriceBook::load");
+
+    // Held across the retries, fetch() runs on whatever thread asked for the prices
+    ConnectionPool::Lease lease;
+
+    QVector<quint16> missing;
+    quint64 generation;
+    {
+        QReadLocker locker(&_lock);
+        generation = _generation;
+        for (quint16 id: productIds) {
+            if (!_tables.contains(id))
+                missing << id;
+        }
+    }
+
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+    // Ids invalidated while their query ran are read again, a few times at most
+    for (int attempt = 0; attempt < 3 && !missing.isEmpty(); attempt++) {
+        QHash<quint16, QVector<PriceTable::Tier> > tiers;
+        if (!fetch(missing, &tiers))
+            return false;
+
+        QVector<quint16> stale;
+        QWriteLocker locker(&_lock);
+        bool cleared = _clearedAt > generation;
+        for (quint16 id: missing) {
+            if (cleared || _invalidatedAt.value(id) > generation) {
+                stale << id;
+                continue;
+            }
+            // Products without tiers are cached too, so they are not asked for again
+            _tables.insert(id, PriceTable(tiers.value(id)));
+        }
+
+        generation = _generation;
+        missing.swap(stale);
+    }
+
+    return true;
+}
+
+bool PriceBook::reload(const QVector<quint16>& productIds)
+{
+    {
+        QWriteLocker locker(&_lock);
+        for (quint16 id: productIds)
+            _tables.remove(id);
+    }
+    return load(productIds);
+}
+
+bool PriceBook::fetch(const QVector<quint16>& productIds, QHash<quint16, QVector<PriceTable::Tier> >* tiers)
+{
+    // Ids are numbers, so they go into the statement instead of thousands of bind values
+    QStringList ids;
+    ids.reserve(productIds.size());
+    for (quint16 id: productIds)
+        ids << QString::number(id);
+
+    QSqlQuery q(ConnectionPool::instance()->database());
+    q.setForwardOnly(true);
+    q.prepare(QString("select productId, quantityMin, quantityMax,"
+                      " price1Min, price1Max, price2Min, price2Max, price3Min, price3Max"
+                      " from product_prices where productId in (%1)"
+                      " order by productId").arg(ids.join(',')));
+    if (!Sql::exec(q)) {
+        qDebug() << "SQL ERROR:" << q.lastError().text();
+        return false;
+    }
+
+    tiers->reserve(productIds.size());
+    while (q.next()) {
+        PriceTable::Tier tier;
+        tier.quantityMin = q.value(1).toULongLong();
+        tier.quantityMax = q.value(2).toULongLong();
+        for (int i = 0; i < PriceTable::LevelCount; i++) {
+            tier.priceMin[i] = q.value(3 + i * 2).toULongLong();
+            tier.priceMax[i] = q.value(4 + i * 2).toULongLong();
+        }
+        (*tiers)[q.value(0).value<quint16>()] << tier;
+    }
+
+    return true;
+}
+
+void PriceBook::invalidate(quint16 productId)
+{
+    QWriteLocker locker(&_lock);
+    _tables.remove(productId);
+    _invalidatedAt.insert(productId, ++_generation);
+}
+
+void PriceBook::clear()
+{
+    QWriteLocker locker(&_lock);
+    _tables.clear();
+    // Every id counts as invalidated now, the per-id marks are no longer needed
+    _invalidatedAt.clear();
+    _clearedAt = ++_generation;
+}
+
+bool PriceBook::contains(quint16 productId) const
+{
+    QReadLocker locker(&_lock);
+    return _tables.contains(productId);
+}
+
+PriceTable PriceBook::table(quint16 productId) const
+{
+    QReadLocker locker(&_lock);
+    return _tables.value(productId);
+}
+
+QVector<PriceBook::LinePrice> PriceBook::priceCart(const QVector<CartLine>& lines)
+{
+    SIMS_TRACE_SCOPE("PriceBook::priceCart");
+
+    QVector<quint16> ids;
+    ids.reserve(lines.size());
+    for (const CartLine& line: lines)
+        ids << line.productId;
+    load(ids);
+
+    QVector<LinePrice> result(lines.size());
+
+    QReadLocker locker(&_lock);
+    for (int i = 0; i < lines.size(); i++) {
+        const CartLine& line = lines.at(i);
+        LinePrice& price = result[i];
+        price.found = false;
+        price.unitPrice = 0;
+        price.lowestPrice = 0;
+        price.total = 0;
+
+        QHash<quint16, PriceTable>::const_iterator it = _tables.constFind(line.productId);
+        if (it == _tables.constEnd())
+            continue;
+
+        if (it.value().price(line.quantity, line.level, &price.unitPrice, &price.lowestPrice)) {
+            price.found = true;
+            price.total = price.unitPrice * line.quantity;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef PRICEBOOK_H
+#define PRICEBOOK_H
+
+#include "pricetable.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QVector>
+
+// Price tables for many products, loaded on demand and kept until invalidated.
+// Safe to share between threads, lookups only take a read lock.
+class PriceBook
+{
+public:
+    struct CartLine
+    {
+        quint16 productId;
+        quint64 quantity;
+        int level;
+    };
+
+    struct LinePrice
+    {
+        bool found;
+        quint64 unitPrice;
+        quint64 lowestPrice;
+        quint64 total;
+    };
+
+    PriceBook();
+
+    // Loads every product not cached yet in a single query
+    bool load(const QVector<quint16>& productIds);
+    // Reads the products again even when cached, for output that must show the
+    // prices in the database right now rather than what this process last saw
+    bool reload(const QVector<quint16>& productIds);
+
+    void invalidate(quint16 productId);
+    void clear();
+
+    bool contains(quint16 productId) const;
+    PriceTable table(quint16 productId) const;
+
+    // Prices every line in one call, fetching the missing products first.
+    // Lines of products without a matching tier come back with found set to false.
+    QVector<LinePrice> priceCart(const QVector<CartLine>& lines);
+
+    static PriceBook* instance();
+
+private:
+    bool fetch(const QVector<quint16>& productIds, QHash<quint16, QVector<PriceTable::Tier> >* tiers);
+
+    mutable QReadWriteLock _lock;
+    QHash<quint16, PriceTable> _tables;
+    // Bumped by invalidate() and clear(). A load that started before an id was
+    // invalidated read it from before the save and must not cache it.
+    quint64 _generation;
+    quint64 _clearedAt;
+    QHash<quint16, quint64> _invalidatedAt;
+};
+
+#endif // PRICEBOOK_H
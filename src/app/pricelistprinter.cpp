@@ -0,0 +1,255 @@
+#include "pricelistprinter.h"
+#include "productcatalogreader.h"
+#include "pagespooler.h"
+#include "product.h"
+#include "trace.h"
+
+#include <QPdfWriter>
+#include <QPainter>
+#include <QFile>
+#include <QDate>
+#include <QLocale>
+#include <QFontMetricsF>
+
+namespace {
+
+// Layout units are points, the painter scales them to the device
+const qreal RowHeight = 12;
+const qreal HeaderHeight = 36;
+
+struct Page
+{
+    int number;
+    QVector<ProductCatalogReader::Entry> entries;
+};
+
+struct Layout
+{
+    qreal width;
+    qreal height;
+    int rowsPerPage;
+
+    // Left edges, the last one is the right edge of the table
+    enum Column { Code, Name, Units, Quantity, Price1, Price2, Price3, End };
+    qreal x[End + 1];
+
+    Layout(const QSizeF& pageSize)
+    {
+        width = pageSize.width();
+        height = pageSize.height();
+        rowsPerPage = qMax(1, int((height - HeaderHeight) / RowHeight));
+
+        const qreal priceWidth = 62;
+        x[End] = width;
+        x[Price3] = x[End] - priceWidth;
+        x[Price2] = x[Price3] - priceWidth;
+        x[Price1] = x[Price2] - priceWidth;
+        x[Quantity] = x[Price1] - 55;
+        x[Units] = x[Quantity] - 90;
+        x[Code] = 0;
+        x[Name] = 48;
+    }
+
+    QRectF cell(int column, qreal y) const
+    {
+        return QRectF(x[column] + 2, y, x[column + 1] - x[column] - 4, RowHeight);
+    }
+};
+
+int rowCount(const ProductCatalogReader::Entry& entry)
+{
+    return qMax(1, entry.tiers.size());
+}
+
+QString quantityText(const PriceTable::Tier& tier, const QLocale& locale)
+{
+    if (tier.isOpenEnded())
+        return QString(">= %1").arg(locale.toString(tier.quantityMin));
+    if (tier.quantityMin == tier.quantityMax)
+        return locale.toString(tier.quantityMin);
+    return QString("%1 - %2").arg(locale.toString(tier.quantityMin), locale.toString(tier.quantityMax));
+}
+
+QString priceText(quint64 min, quint64 max, const QLocale& locale)
+{
+    if (!min && !max)
+        return "-";
+    if (min == max)
+        return locale.toString(max);
+    return QString("%1 - %2").arg(locale.toString(min), locale.toString(max));
+}
+
+void paintPage(QPainter* painter, const Page& page, const Layout& layout)
+{
+    QLocale locale;
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setRenderHint(QPainter::TextAntialiasing);
+
+    QFont titleFont;
+    titleFont.setPixelSize(12);
+    titleFont.setBold(true);
+    QFont headerFont;
+    headerFont.setPixelSize(8);
+    headerFont.setBold(true);
+    QFont font;
+    font.setPixelSize(8);
+    QFontMetricsF metrics(font);
+
+    QPen linePen(Qt::black, 0.5);
+    QPen separatorPen(Qt::gray, 0.25);
+
+    painter->setFont(titleFont);
+    painter->drawText(QRectF(0, 0, layout.width, 18), Qt::AlignLeft | Qt::AlignVCenter, "Daftar Harga");
+    painter->setFont(font);
+    painter->drawText(QRectF(0, 0, layout.width, 18), Qt::AlignRight | Qt::AlignVCenter,
+                      QString("%1    Halaman %2").arg(locale.toString(QDate::currentDate(), QLocale::LongFormat))
+                      .arg(page.number));
+
+    qreal y = HeaderHeight - RowHeight - 2;
+    painter->setFont(headerFont);
+    const char* const headers[] = { "Kode", "Nama Produk", "Satuan", "Kwantitas", "Harga 1", "Harga 2", "Harga 3" };
+    for (int column = Layout::Code; column < Layout::End; column++) {
+        Qt::Alignment alignment = column >= Layout::Quantity ? Qt::AlignRight : Qt::AlignLeft;
+        painter->drawText(layout.cell(column, y), alignment | Qt::AlignVCenter, headers[column]);
+    }
+    painter->setPen(linePen);
+    painter->drawLine(QPointF(0, HeaderHeight - 1), QPointF(layout.width, HeaderHeight - 1));
+
+    painter->setFont(font);
+    y = HeaderHeight;
+    for (const ProductCatalogReader::Entry& entry: page.entries) {
+        painter->setPen(Qt::black);
+
+        QStringList units(entry.baseUom);
+        for (const QPair<QString, quint64>& uom: entry.uoms)
+            units << QString("%1 (%2)").arg(uom.first, locale.toString(uom.second));
+
+        QRectF nameCell = layout.cell(Layout::Name, y);
+        QRectF unitsCell = layout.cell(Layout::Units, y);
+        painter->drawText(layout.cell(Layout::Code, y), Qt::AlignLeft | Qt::AlignVCenter, Product::formatCode(entry.id));
+        painter->drawText(nameCell, Qt::AlignLeft | Qt::AlignVCenter,
+                          metrics.elidedText(entry.name, Qt::ElideRight, nameCell.width()));
+        painter->drawText(unitsCell, Qt::AlignLeft | Qt::AlignVCenter,
+                          metrics.elidedText(units.join(", "), Qt::ElideRight, unitsCell.width()));
+
+        if (entry.tiers.isEmpty()) {
+            painter->drawText(layout.cell(Layout::Quantity, y), Qt::AlignRight | Qt::AlignVCenter, "-");
+        }
+        for (int i = 0; i < entry.tiers.size(); i++) {
+            const PriceTable::Tier& tier = entry.tiers.at(i);
+            qreal rowY = y + i * RowHeight;
+            painter->drawText(layout.cell(Layout::Quantity, rowY), Qt::AlignRight | Qt::AlignVCenter,
+                              quantityText(tier, locale));
+            for (int level = 0; level < PriceTable::LevelCount; level++) {
+                painter->drawText(layout.cell(Layout::Price1 + level, rowY), Qt::AlignRight | Qt::AlignVCenter,
+                                  priceText(tier.priceMin[level], tier.priceMax[level], locale));
+            }
+        }
+
+        y += rowCount(entry) * RowHeight;
+        painter->setPen(separatorPen);
+        painter->drawLine(QPointF(0, y), QPointF(layout.width, y));
+    }
+}
+
+}
+
+bool PriceListPrinter::print(QPagedPaintDevice* device, bool raster, const ProgressCallback& progress, QString* error)
+{
+    SIMS_TRACE_SCOPE("PriceListPrinter::print");
+
+    auto fail = [error](const QString& text) {
+        if (error)
+            *error = text;
+        return false;
+    };
+
+    ProductCatalogReader reader;
+    reader.setActiveOnly(true);
+    int total = 0;
+    if (!reader.count(&total))
+        return fail(reader.errorString());
+
+    PageSpooler spooler(device, raster);
+    if (!spooler.begin())
+        return fail("Printer tidak dapat digunakan.");
+
+    const Layout layout(spooler.pageSize());
+    const int batchSize = spooler.batchSize();
+    int done = 0;
+
+    auto flush = [&](const QVector<Page>& pages) {
+        QVector<PageSpooler::PagePainter> painters;
+        painters.reserve(pages.size());
+        for (const Page& page: pages) {
+            painters << [page, &layout](QPainter* painter) { paintPage(painter, page, layout); };
+            done += page.entries.size();
+        }
+        spooler.spool(painters);
+        return !progress || progress(done, total);
+    };
+
+    auto abort = [&spooler, &fail](const QString& text) {
+        spooler.abort();
+        return fail(text);
+    };
+
+    // Products never straddle pages, a page takes them while their tiers fit
+    QVector<Page> pending;
+    Page current;
+    current.number = 1;
+    int usedRows = 0;
+
+    QVector<ProductCatalogReader::Entry> entries;
+    forever {
+        if (!reader.next(&entries))
+            return abort(reader.errorString());
+        if (entries.isEmpty())
+            break;
+
+        for (const ProductCatalogReader::Entry& entry: entries) {
+            int rows = rowCount(entry);
+            if (usedRows + rows > layout.rowsPerPage && !current.entries.isEmpty()) {
+                pending << current;
+                current.entries.clear();
+                current.number++;
+                usedRows = 0;
+
+                if (pending.size() >= batchSize) {
+                    if (!flush(pending))
+                        return abort("Pencetakan dibatalkan.");
+                    pending.clear();
+                }
+            }
+            current.entries << entry;
+            usedRows += rows;
+        }
+    }
+
+    if (!current.entries.isEmpty() || current.number == 1)
+        pending << current;
+    if (!flush(pending))
+        return abort("Pencetakan dibatalkan.");
+
+    if (!spooler.end())
+        return fail("Halaman gagal dikirim ke printer.");
+
+    return true;
+}
+
+bool PriceListPrinter::printToPdf(const QString& path, const ProgressCallback& progress, QString* error)
+{
+    bool ok;
+    {
+        QPdfWriter writer(path);
+        writer.setTitle("Daftar Harga");
+        writer.setPageSize(QPageSize(QPageSize::A4));
+        writer.setPageMargins(QMarginsF(12, 12, 12, 12), QPageLayout::Millimeter);
+        ok = print(&writer, false, progress, error);
+    }
+
+    if (!ok)
+        QFile::remove(path);
+
+    return ok;
+}
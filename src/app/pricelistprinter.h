@@ -0,0 +1,30 @@
+#ifndef PRICELISTPRINTER_H
+#define PRICELISTPRINTER_H
+
+#include <QString>
+#include <functional>
+
+class QPagedPaintDevice;
+
+// Prints the price list of active products: code, name, units and the
+// three price levels of every quantity tier. Products are read a page at
+// a time, a batch of pages is drawn on the global thread pool and the
+// finished pages go to the device in order, so only a batch is ever held.
+// Call from a worker thread, it blocks until the last page is out.
+class PriceListPrinter
+{
+public:
+    // Called after every batch of pages, returning false cancels
+    typedef std::function<bool(int done, int total)> ProgressCallback;
+
+    // Raster pages are drawn as images, for printers that rasterize anyway.
+    // Vector pages keep text as text, for PDF.
+    static bool print(QPagedPaintDevice* device, bool raster,
+                      const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+
+    // A4 with vector pages, the file is removed again when printing fails
+    static bool printToPdf(const QString& path,
+                           const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+};
+
+#endif // PRICELISTPRINTER_H
@@ -0,0 +1,129 @@
+#include "pricetable.h"
+
+#include <QLocale>
+
+#include <algorithm>
+#include <limits>
+
+PriceTable::Tier::Tier()
+    : quantityMin(0)
+    , quantityMax(0)
+{
+    for (int i = 0; i < LevelCount; i++) {
+        priceMin[i] = 0;
+        priceMax[i] = 0;
+    }
+}
+
+bool PriceTable::Tier::contains(quint64 quantity) const
+{
+    return quantity >= quantityMin && (isOpenEnded() || quantity <= quantityMax);
+}
+
+PriceTable::PriceTable()
+{
+}
+
+PriceTable::PriceTable(const QVector<Tier>& tiers)
+{
+    setTiers(tiers);
+}
+
+void PriceTable::setTiers(const QVector<Tier>& tiers)
+{
+    _tiers.clear();
+    _tiers.reserve(tiers.size());
+    for (const Tier& tier: tiers) {
+        if (tier.quantityMin != 0)
+            _tiers << tier;
+    }
+
+    std::stable_sort(_tiers.begin(), _tiers.end(), [](const Tier& a, const Tier& b) {
+        return a.quantityMin < b.quantityMin;
+    });
+
+    // Lookups only touch these arrays until the tier is found
+    _mins.resize(_tiers.size());
+    _reach.resize(_tiers.size());
+    quint64 reach = 0;
+    for (int i = 0; i < _tiers.size(); i++) {
+        const Tier& tier = _tiers.at(i);
+        _mins[i] = tier.quantityMin;
+        reach = qMax(reach, tier.isOpenEnded() ? std::numeric_limits<quint64>::max() : tier.quantityMax);
+        _reach[i] = reach;
+    }
+}
+
+int PriceTable::indexOf(quint64 quantity) const
+{
+    // The last tier starting at or below the quantity, then earlier ones in case it ends too soon
+    int index = int(std::upper_bound(_mins.constBegin(), _mins.constEnd(), quantity) - _mins.constBegin()) - 1;
+    // Stops as soon as no tier up to the index reaches the quantity, including open-ended ones
+    for (; index >= 0 && _reach.at(index) >= quantity; index--) {
+        if (_tiers.at(index).contains(quantity))
+            return index;
+    }
+    return -1;
+}
+
+bool PriceTable::price(quint64 quantity, int level, quint64* listPrice, quint64* lowestPrice) const
+{
+    if (level < 1 || level > LevelCount)
+        return false;
+
+    int index = indexOf(quantity);
+    if (index == -1)
+        return false;
+
+    const Tier& tier = _tiers.at(index);
+    quint64 max = tier.priceMax[level - 1];
+    quint64 min = tier.priceMin[level - 1];
+    if (!max && !min)
+        return false;
+
+    // A single price is stored with min and max equal, a range keeps both
+    *listPrice = max ? max : min;
+    if (lowestPrice)
+        *lowestPrice = min ? min : max;
+    return true;
+}
+
+QStringList PriceTable::problems() const
+{
+    QLocale locale;
+    QStringList result;
+
+    auto range = [&locale](const Tier& tier) {
+        if (tier.isOpenEnded())
+            return QString(">= %1").arg(locale.toString(tier.quantityMin));
+        if (tier.quantityMin == tier.quantityMax)
+            return locale.toString(tier.quantityMin);
+        return QString("%1 - %2").arg(locale.toString(tier.quantityMin), locale.toString(tier.quantityMax));
+    };
+
+    if (!_tiers.isEmpty() && _tiers.first().quantityMin > 1) {
+        result << QString("Tidak ada harga untuk kwantitas di bawah %1.")
+                  .arg(locale.toString(_tiers.first().quantityMin));
+    }
+
+    // Each tier is checked against the furthest reach of all tiers before it, not only the
+    // one just before, so a wide early tier still shows as the overlap and leaves no false gap
+    int reachIndex = 0;
+    for (int i = 1; i < _tiers.size(); i++) {
+        const Tier& tier = _tiers.at(i);
+        const quint64 reach = _reach.at(i - 1);
+
+        if (tier.quantityMin <= reach) {
+            result << QString("Kwantitas %1 bertumpuk dengan %2.").arg(range(tier), range(_tiers.at(reachIndex)));
+        }
+        else if (tier.quantityMin > reach + 1) {
+            result << QString("Tidak ada harga untuk kwantitas %1 - %2.")
+                      .arg(locale.toString(reach + 1), locale.toString(tier.quantityMin - 1));
+        }
+
+        if (_reach.at(i) > reach)
+            reachIndex = i;
+    }
+
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef PRICETABLE_H
+#define PRICETABLE_H
+
+#include <QVector>
+#include <QStringList>
+
+// A product's quantity tiers, sorted for binary search.
+// A tier covers quantityMin up to quantityMax, or everything from
+// quantityMin up when quantityMax is 0, like the editor's ">= n" rows.
+// Each tier has three price levels, each a min/max pair where the max is
+// the list price and the min the lowest price a cashier may give.
+class PriceTable
+{
+public:
+    static const int LevelCount = 3;
+
+    struct Tier
+    {
+        quint64 quantityMin;
+        quint64 quantityMax;
+        quint64 priceMin[LevelCount];
+        quint64 priceMax[LevelCount];
+
+        Tier();
+
+        bool isOpenEnded() const { return quantityMax == 0; }
+        bool contains(quint64 quantity) const;
+    };
+
+    PriceTable();
+    explicit PriceTable(const QVector<Tier>& tiers);
+
+    void setTiers(const QVector<Tier>& tiers);
+    const QVector<Tier>& tiers() const { return _tiers; }
+    bool isEmpty() const { return _tiers.isEmpty(); }
+
+    // -1 when no tier covers the quantity; with overlapping tiers the one starting last wins
+    int indexOf(quint64 quantity) const;
+
+    // Level is 1 to 3, false when no tier covers the quantity or the level has no price
+    bool price(quint64 quantity, int level, quint64* listPrice, quint64* lowestPrice = 0) const;
+
+    // Overlapping and missing quantity ranges, as messages for the user
+    QStringList problems() const;
+
+private:
+    QVector<Tier> _tiers;
+    QVector<quint64> _mins;
+    // Highest quantity any tier up to this index covers, the maximum for open-ended ones
+    QVector<quint64> _reach;
+};
+
+#endif // PRICETABLE_H
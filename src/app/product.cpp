@@ -21,7 +21,7 @@ QString Product::costingMethodString(CostingMethod type)
     return QString();
 }
 
-QString Product::formatCode(quint16 id)
+QString Product::formatCode(quint32 id)
 {
     return QString("P-%1").arg(id, 5, 10, QChar('0'));
 }
@@ -22,7 +22,7 @@ public:
 
     static QString costingMethodString(CostingMethod type);
     static QString typeString(Type type);
-    static QString formatCode(quint16 id);
+    static QString formatCode(quint32 id);
 };
 
 
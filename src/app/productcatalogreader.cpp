@@ -0,0 +1,117 @@
+#include "productcatalogreader.h"
+#include "connectionpool.h"
+#include "sql.h"
+#include "trace.h"
+
+#include <QSqlError>
+#include <QHash>
+
+ProductCatalogReader::ProductCatalogReader(int pageSize)
+    : _query(_lease.database())
+    , _pageSize(qMax(1, pageSize))
+    , _activeOnly(false)
+    , _done(false)
+    , _lastId(0)
+{
+    _query.setForwardOnly(true);
+}
+
+QString ProductCatalogReader::condition() const
+{
+    // Vouchers and other system products are not part of the catalog
+    return _activeOnly ? "type<200 and active=1" : "type<200";
+}
+
+bool ProductCatalogReader::count(int* total)
+{
+    if (!Sql::exec(_query, QString("select count(0) from products where %1").arg(condition()))) {
+        _error = _query.lastError().text();
+        return false;
+    }
+
+    *total = _query.next() ? _query.value(0).toInt() : 0;
+    _query.finish();
+    return true;
+}
+
+bool ProductCatalogReader::next(QVector<Entry>* page)
+{
+    SIMS_TRACE_SCOPE("ProductCatalogReader::next");
+
+    page->clear();
+    if (_done)
+        return true;
+
+    _query.prepare(QString("select id, name, type, active, baseUom, manualCost from products"
+                           " where %1 and id>? order by id limit %2").arg(condition()).arg(_pageSize));
+    _query.addBindValue(_lastId);
+    if (!Sql::exec(_query)) {
+        _error = _query.lastError().text();
+        return false;
+    }
+
+    QHash<quint32, int> indexById;
+    while (_query.next()) {
+        Entry entry;
+        entry.id = _query.value(0).toUInt();
+        entry.name = _query.value(1).toString();
+        entry.type = _query.value(2).value<quint8>();
+        entry.active = _query.value(3).toBool();
+        entry.baseUom = _query.value(4).toString();
+        entry.manualCost = _query.value(5).toULongLong();
+        indexById.insert(entry.id, page->size());
+        *page << entry;
+    }
+    _query.finish();
+
+    if (page->size() < _pageSize)
+        _done = true;
+    if (page->isEmpty())
+        return true;
+
+    quint32 firstId = page->first().id;
+    _lastId = page->last().id;
+
+    // Units and tiers of the whole page in one range query each
+    _query.prepare("select productId, name, quantity from product_uoms"
+                   " where productId between ? and ? order by productId, id");
+    _query.addBindValue(firstId);
+    _query.addBindValue(_lastId);
+    if (!Sql::exec(_query)) {
+        _error = _query.lastError().text();
+        return false;
+    }
+    while (_query.next()) {
+        int index = indexById.value(_query.value(0).toUInt(), -1);
+        if (index != -1)
+            (*page)[index].uoms << qMakePair(_query.value(1).toString(), _query.value(2).toULongLong());
+    }
+    _query.finish();
+
+    _query.prepare("select productId, quantityMin, quantityMax,"
+                   " price1Min, price1Max, price2Min, price2Max, price3Min, price3Max from product_prices"
+                   " where productId between ? and ? order by productId, quantityMin");
+    _query.addBindValue(firstId);
+    _query.addBindValue(_lastId);
+    if (!Sql::exec(_query)) {
+        _error = _query.lastError().text();
+        return false;
+    }
+    while (_query.next()) {
+        int index = indexById.value(_query.value(0).toUInt(), -1);
+        if (index == -1)
+            continue;
+
+        PriceTable::Tier tier;
+        tier.quantityMin = _query.value(1).toULongLong();
+        tier.quantityMax = _query.value(2).toULongLong();
+        for (int i = 0; i < PriceTable::LevelCount; i++) {
+            tier.priceMin[i] = _query.value(3 + i * 2).toULongLong();
+            tier.priceMax[i] = _query.value(4 + i * 2).toULongLong();
+        }
+        (*page)[index].tiers << tier;
+    }
+    _query.finish();
+
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef PRODUCTCATALOGREADER_H
+#define PRODUCTCATALOGREADER_H
+
+#include "pricetable.h"
+#include "connectionpool.h"
+
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include <QSqlQuery>
+
+// Reads products with their units and price tiers a page at a time.
+// Pages follow the primary key ("id > last order by id limit n"), so each one
+// is an index range scan and memory use depends on the page size, not on the
+// size of the catalog. Leases the ConnectionPool connection of the calling
+// thread for as long as the reader lives.
+class ProductCatalogReader
+{
+public:
+    struct Entry
+    {
+        // Wider than the 16 bit ids elsewhere, so a catalog past 65535 rows can not wrap the cursor
+        quint32 id;
+        QString name;
+        quint8 type;
+        bool active;
+        QString baseUom;
+        quint64 manualCost;
+        QVector<QPair<QString, quint64> > uoms;
+        // Sorted by minimum quantity
+        QVector<PriceTable::Tier> tiers;
+    };
+
+    explicit ProductCatalogReader(int pageSize = 1000);
+
+    // Leaves out inactive products
+    void setActiveOnly(bool activeOnly) { _activeOnly = activeOnly; }
+
+    // Products the reader will go through, for progress
+    bool count(int* total);
+
+    // False on errors, an empty page once every product has been read
+    bool next(QVector<Entry>* page);
+
+    QString errorString() const { return _error; }
+
+private:
+    QString condition() const;
+
+    // Before the query, so the connection is given back only after the query is gone
+    ConnectionPool::Lease _lease;
+    QSqlQuery _query;
+    int _pageSize;
+    bool _activeOnly;
+    bool _done;
+    quint32 _lastId;
+    QString _error;
+};
+
+#endif // PRODUCTCATALOGREADER_H
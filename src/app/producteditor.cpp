@@ -1,6 +1,12 @@
 #include "producteditor.h"
 #include "ui_producteditor.h"
 #include "product.h"
+#include "connectionpool.h"
+#include "sql.h"
+#include "trace.h"
+#include "pricetable.h"
+#include "pricebook.h"
+#include "costingengine.h"
 
 #include <QAbstractTableModel>
 #include <QToolBar>
@@ -12,8 +18,14 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QSqlDriver>
+#include <QStringList>
 #include <QDebug>
 #include <QTimer>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLineEdit>
 
 class ProductEditor::UomModel : public QAbstractTableModel
 {
@@ -27,6 +39,10 @@ public:
         QString name;
         quint64 quantity;
 
+        // Display text, formatted once when the item changes instead of on every paint
+        QString quantityText;
+        QString descriptionText;
+
         Item() : id(0), quantity(0) {}
 
         bool isNull() const {
@@ -45,28 +61,16 @@ public:
         items << Item();
     }
 
-    bool load(quint16 productId)
+    void setItems(const QList<Item>& newItems)
     {
-        QSqlQuery q("select id, name, quantity from product_uoms where productId=?", QSqlDatabase::database());
-        q.bindValue(0, productId);
-        if (!q.exec()) {
-            qDebug() << q.lastError().text();
-            return false;
-        }
-
         beginResetModel();
-        items.clear();
-        while (q.next()) {
-            Item item;
-            item.id = q.value("id").toULongLong();
-            item.name = q.value("name").toString();
-            item.quantity = q.value("quantity").toULongLong();
-            items << item;
-        }
+        items = newItems;
+        deletedIds.clear();
+        for (Item& item: items)
+            updateText(item);
         if (items.size() < 5)
             items << Item();
         endResetModel();
-        return true;
     }
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const
@@ -93,7 +97,7 @@ public:
                 }
             }
             else {
-                Item item = items.at(section);
+                const Item& item = items.at(section);
                 if (item.isNull())
                     return "*";
                 return QString::number(section + 1);
@@ -107,7 +111,7 @@ public:
     {
         Qt::ItemFlags f = Qt::ItemIsSelectable | Qt::ItemIsEnabled;
 
-        Item item = items.at(index.row());
+        const Item& item = items.at(index.row());
 
         if ((item.isNull() && index.column() != 0) || index.column() == 2)
             return f;
@@ -120,14 +124,13 @@ public:
         if (index.row() == items.size())
             return QVariant();
 
-        Item item = items.at(index.row());
+        const Item& item = items.at(index.row());
 
         if (role == Qt::DisplayRole) {
             switch (index.column()) {
             case 0: return item.name;
-            case 1: return item.quantity ? QLocale().toString(item.quantity) : QVariant();
-            case 2: return item.isNull() ? QVariant()
-                                         : QString("1 %2 = %3 %4").arg(item.name, QLocale().toString(item.quantity), baseUom.size() != 0 ? baseUom : "satuan");
+            case 1: return item.quantity ? item.quantityText : QVariant();
+            case 2: return item.isNull() ? QVariant() : item.descriptionText;
             }
         }
         else if (role == Qt::EditRole) {
@@ -187,6 +190,7 @@ public:
             }
 
             item.name = name;
+            updateText(item);
             emit dataChanged(index, index.sibling(index.row(), columnCount() - 1));
             return true;
         }
@@ -194,6 +198,7 @@ public:
             quint64 quantity = value.value<quint64>();
             if (!quantity) return false;
             item.quantity = quantity;
+            updateText(item);
             emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), columnCount() - 1));
             return true;
         }
@@ -228,10 +233,21 @@ public slots:
     {
         baseUom = uom;
 
+        for (Item& item: items)
+            updateText(item);
+
         if (items.size() > 0)
             emit dataChanged(index(0, 2), index(items.size() - 1, 2));
     }
 
+private:
+    void updateText(Item& item)
+    {
+        item.quantityText = _locale.toString(item.quantity);
+        item.descriptionText = QString("1 %2 = %3 %4").arg(item.name, item.quantityText, baseUom.size() != 0 ? baseUom : "satuan");
+    }
+
+    QLocale _locale;
 };
 
 class ProductEditor::PriceModel : public QAbstractTableModel
@@ -251,35 +267,63 @@ public:
         ItemPricePair price2;
         ItemPricePair price3;
 
+        // Display text per column, formatted once when the item changes instead of on every paint
+        QString text[4];
+
         Item() : id(0), quantity(ItemPricePair(0, 0)),
             price1(ItemPricePair(0, 0)), price2(ItemPricePair(0, 0)), price3(ItemPricePair(0, 0))
         {}
 
-        QString quantityString() const {
+        QString quantityString(const QLocale& locale) const {
             if (quantity.first && quantity.first == quantity.second)
-                return QLocale().toString(quantity.first);
+                return locale.toString(quantity.first);
             else if (quantity.first && !quantity.second)
-                return QString(">= %1").arg(QLocale().toString(quantity.first));
+                return QString(">= %1").arg(locale.toString(quantity.first));
             else if (quantity.first < quantity.second)
-                return QString("%1 - %2").arg(QLocale().toString(quantity.first), QLocale().toString(quantity.second));
+                return QString("%1 - %2").arg(locale.toString(quantity.first), locale.toString(quantity.second));
 
             return QString();
         }
 
-        QString price1String() const { return priceString(price1); }
-        QString price2String() const { return priceString(price2); }
-        QString price3String() const { return priceString(price3); }
-
-        QString priceString(const ItemPricePair& p) const {
+        QString priceString(const ItemPricePair& p, const QLocale& locale) const {
             if (p.first && p.second) {
                 if (p.first == p.second)
-                    return QLocale().toString(p.first);
-                return QString("%1 - %2").arg(QLocale().toString(p.first), QLocale().toString(p.second));
+                    return locale.toString(p.first);
+                return QString("%1 - %2").arg(locale.toString(p.first), locale.toString(p.second));
             }
 
             return QString();
         }
 
+        // Column values in table order, quantityMin through price3Max
+        QVector<quint64> values() const {
+            return QVector<quint64>()
+                << quantity.first << quantity.second
+                << price1.first << price1.second
+                << price2.first << price2.second
+                << price3.first << price3.second;
+        }
+
+        PriceTable::Tier tier() const {
+            PriceTable::Tier tier;
+            tier.quantityMin = quantity.first;
+            tier.quantityMax = quantity.second;
+            tier.priceMin[0] = price1.first;
+            tier.priceMax[0] = price1.second;
+            tier.priceMin[1] = price2.first;
+            tier.priceMax[1] = price2.second;
+            tier.priceMin[2] = price3.first;
+            tier.priceMax[2] = price3.second;
+            return tier;
+        }
+
+        void updateText(const QLocale& locale) {
+            text[0] = quantityString(locale);
+            text[1] = priceString(price1, locale);
+            text[2] = priceString(price2, locale);
+            text[3] = priceString(price3, locale);
+        }
+
         bool isNull() const {
             return id == 0
                 && quantity.first == 0 && quantity.second == 0
@@ -300,35 +344,16 @@ public:
         items << Item();
     }
 
-    bool load(quint16 productId)
+    void setItems(const QList<Item>& newItems)
     {
-        QSqlQuery q("select * from product_prices where productId=?", QSqlDatabase::database());
-        q.bindValue(0, productId);
-        if (!q.exec()) {
-            qDebug() << q.lastError().text();
-            return false;
-        }
-
         beginResetModel();
-        items.clear();
-        while (q.next()) {
-            Item item;
-            item.id = q.value("id").toULongLong();
-            item.quantity.first  = q.value("quantityMin").toULongLong();
-            item.quantity.second = q.value("quantityMax").toULongLong();
-            item.price1.first  = q.value("price1Min").toULongLong();
-            item.price1.second = q.value("price1Max").toULongLong();
-            item.price2.first  = q.value("price2Min").toULongLong();
-            item.price2.second = q.value("price2Max").toULongLong();
-            item.price3.first  = q.value("price3Min").toULongLong();
-            item.price3.second = q.value("price3Max").toULongLong();
-            items << item;
-        }
+        items = newItems;
+        deletedIds.clear();
+        for (Item& item: items)
+            item.updateText(_locale);
         endResetModel();
 
         addDummyRow();
-
-        return true;
     }
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const
@@ -353,7 +378,7 @@ public:
                 }
             }
             else {
-                Item item = items.at(section);
+                const Item& item = items.at(section);
                 if (item.isNull())
                     return "*";
                 return QString::number(section + 1);
@@ -373,15 +398,11 @@ public:
         if (index.row() == items.size())
             return QVariant();
 
-        Item item = items.at(index.row());
+        const Item& item = items.at(index.row());
 
         if (role == Qt::DisplayRole || role == Qt::EditRole) {
-            switch (index.column()) {
-            case 0: return item.quantityString();
-            case 1: return item.price1String();
-            case 2: return item.price2String();
-            case 3: return item.price3String();
-            }
+            if (index.column() >= 0 && index.column() <= 3)
+                return item.text[index.column()];
         }
         else if (role == Qt::TextAlignmentRole) {
             return Qt::AlignCenter;
@@ -412,19 +433,19 @@ public:
 
         if (index.column() == 0) {
             if (str.startsWith(">=")) {
-                min = QLocale().toULongLong(str.replace(">=", "").trimmed());
+                min = _locale.toULongLong(str.replace(">=", "").trimmed());
             }
             else if (str.contains("-")) {
                 QStringList strList = str.split("-");
                 if (strList.size() != 2)
                     return false;
-                min = QLocale().toULongLong(strList.first().trimmed());
-                max = QLocale().toULongLong(strList.last().trimmed());
+                min = _locale.toULongLong(strList.first().trimmed());
+                max = _locale.toULongLong(strList.last().trimmed());
                 if (min >= max)
                     return false;
             }
             else {
-                min = max = QLocale().toULongLong(str);
+                min = max = _locale.toULongLong(str);
                 if (min <= 0)
                     return false;
             }
@@ -434,6 +455,7 @@ public:
 
             item.quantity.first = min;
             item.quantity.second = max;
+            item.updateText(_locale);
             emit dataChanged(index, index);
             return true;
         }
@@ -442,13 +464,13 @@ public:
                 QStringList strList = str.split("-");
                 if (strList.size() != 2)
                     return false;
-                min = QLocale().toULongLong(strList.first().trimmed());
-                max = QLocale().toULongLong(strList.last().trimmed());
+                min = _locale.toULongLong(strList.first().trimmed());
+                max = _locale.toULongLong(strList.last().trimmed());
                 if (min >= max)
                     return false;
             }
             else {
-                min = max = QLocale().toULongLong(str);
+                min = max = _locale.toULongLong(str);
             }
 
             if (index.row() == items.size() - 1)
@@ -466,6 +488,7 @@ public:
                 item.price3.first  = min;
                 item.price3.second = max;
             }
+            item.updateText(_locale);
             emit dataChanged(index, index);
             return true;
         }
@@ -488,6 +511,9 @@ public:
 
         if (item.id) deletedIds << item.id;
     }
+
+private:
+    QLocale _locale;
 };
 
 ProductEditor::ProductEditor(QWidget *parent)
@@ -506,6 +532,10 @@ ProductEditor::ProductEditor(QWidget *parent)
     duplicateAction->setEnabled(false);
     connect(duplicateAction, SIGNAL(triggered(bool)), SLOT(onDuplicateActionTriggered()));
 
+    purchaseAction = toolBar->addAction("Catat Pembelian");
+    purchaseAction->setEnabled(false);
+    connect(purchaseAction, SIGNAL(triggered(bool)), SLOT(recordPurchase()));
+
     toolBar->addSeparator();
 
     removeAction = toolBar->addAction("Hapus");
@@ -518,12 +548,10 @@ ProductEditor::ProductEditor(QWidget *parent)
     ui->typeComboBox->addItem(Product::typeString(Product::Type::Stocked), Product::Type::Stocked);
     ui->typeComboBox->addItem(Product::typeString(Product::Type::NonStocked), Product::Type::NonStocked);
     ui->typeComboBox->addItem(Product::typeString(Product::Type::Service), Product::Type::Service);
-    ui->typeComboBox->setCurrentIndex(ui->typeComboBox->findData(Product::Type::Stocked));
 
     ui->costingMethodComboBox->addItem(Product::costingMethodString(Product::CostingMethod::Manual), Product::CostingMethod::Manual);
     ui->costingMethodComboBox->addItem(Product::costingMethodString(Product::CostingMethod::Average), Product::CostingMethod::Average);
     ui->costingMethodComboBox->addItem(Product::costingMethodString(Product::CostingMethod::Last), Product::CostingMethod::Last);
-    ui->costingMethodComboBox->setCurrentIndex(ui->costingMethodComboBox->findData(Product::CostingMethod::Average));
 
     connect(ui->baseUomEdit, SIGNAL(textEdited(QString)), uomModel, SLOT(updateBaseUom(QString)));
 
@@ -539,7 +567,7 @@ ProductEditor::ProductEditor(QWidget *parent)
     mainLayout->addWidget(toolBar);
     mainLayout->addWidget(mainFrame);
 
-    setWindowTitle("Produk Baru");
+    reset();
     QTimer::singleShot(0, ui->nameEdit, SLOT(setFocus()));
 }
 
@@ -549,41 +577,88 @@ ProductEditor::~ProductEditor()
 }
 
 bool ProductEditor::load(quint16 productId) {
-    id = productId;
-
-    QSqlQuery q("select * from products where id=?", QSqlDatabase::database());
-    q.bindValue(0, productId);
-    if (!q.exec()) {
+    SIMS_TRACE_SCOPE("ProductEditor::load");
+
+    // Product, units and price tiers in one round trip, told apart by the first column:
+    // 0 = product, 1 = unit, 2 = price tier
+    QSqlQuery q(ConnectionPool::instance()->database());
+    q.setForwardOnly(true);
+    q.prepare("select 0, id, name, baseUom, type, active, costingMethod, manualCost, averageCost, lastPurchaseCost, 0, 0"
+              " from products where id=?"
+              " union all"
+              " select 1, id, name, '', quantity, 0, 0, 0, 0, 0, 0, 0"
+              " from product_uoms where productId=?"
+              " union all"
+              " select 2, id, '', '', quantityMin, quantityMax, price1Min, price1Max, price2Min, price2Max, price3Min, price3Max"
+              " from product_prices where productId=?"
+              " order by 1, 2");
+    q.addBindValue(productId);
+    q.addBindValue(productId);
+    q.addBindValue(productId);
+    if (!Sql::exec(q)) {
         qDebug() << q.lastError().text();
         return false;
     }
 
-    if (!q.next()) {
+    if (!q.next() || q.value(0).toInt() != 0)
         return false;
-    }
 
-    quint8 type = q.value("type").value<quint8>();
+    quint8 type = q.value(4).value<quint8>();
     if (type >= 200)
         return false;
 
+    QString name = q.value(2).toString();
+    QString baseUom = q.value(3).toString();
+    bool active = q.value(5).toBool();
+    int costingMethod = q.value(6).toInt();
+    quint64 manualCost = q.value(7).toULongLong();
+    quint64 averageCost = q.value(8).toULongLong();
+    quint64 lastPurchaseCost = q.value(9).toULongLong();
+
+    QList<UomModel::Item> uoms;
+    QList<PriceModel::Item> prices;
+    while (q.next()) {
+        if (q.value(0).toInt() == 1) {
+            UomModel::Item item;
+            item.id = q.value(1).toULongLong();
+            item.name = q.value(2).toString();
+            item.quantity = q.value(4).toULongLong();
+            uoms << item;
+        }
+        else {
+            PriceModel::Item item;
+            item.id = q.value(1).toULongLong();
+            item.quantity.first  = q.value(4).toULongLong();
+            item.quantity.second = q.value(5).toULongLong();
+            item.price1.first  = q.value(6).toULongLong();
+            item.price1.second = q.value(7).toULongLong();
+            item.price2.first  = q.value(8).toULongLong();
+            item.price2.second = q.value(9).toULongLong();
+            item.price3.first  = q.value(10).toULongLong();
+            item.price3.second = q.value(11).toULongLong();
+            prices << item;
+        }
+    }
+
+    id = productId;
     QString productCode = Product::formatCode(id);
-    QString baseUom = q.value("baseUom").toString();
 
     ui->idEdit->setText(productCode);
-    ui->nameEdit->setText(q.value("name").toString());
+    ui->nameEdit->setText(name);
     ui->typeComboBox->setCurrentIndex(ui->typeComboBox->findData(type));
-    ui->statusComboBox->setCurrentIndex(q.value("active").toBool());
-    uomModel->load(id);
+    ui->statusComboBox->setCurrentIndex(active);
+    uomModel->setItems(uoms);
     ui->baseUomEdit->setText(baseUom);
     uomModel->updateBaseUom(baseUom);
-    priceModel->load(id);
-    ui->costingMethodComboBox->setCurrentIndex(ui->costingMethodComboBox->findData(q.value("costingMethod").toInt()));
-    ui->manualCostEdit->setText(QLocale().toString(q.value("manualCost").toULongLong()));
-    ui->averageCostEdit->setText(QLocale().toString(q.value("averageCost").toULongLong()));
-    ui->lastPurchaseCostEdit->setText(QLocale().toString(q.value("lastPurchaseCost").toULongLong()));
+    priceModel->setItems(prices);
+    ui->costingMethodComboBox->setCurrentIndex(ui->costingMethodComboBox->findData(costingMethod));
+    ui->manualCostEdit->setText(QLocale().toString(manualCost));
+    ui->averageCostEdit->setText(QLocale().toString(averageCost));
+    ui->lastPurchaseCostEdit->setText(QLocale().toString(lastPurchaseCost));
 
     duplicateAction->setEnabled(true);
     removeAction->setEnabled(true);
+    purchaseAction->setEnabled(true);
     setWindowTitle(productCode);
 
     return true;
@@ -602,8 +677,12 @@ bool ProductEditor::duplicateFrom(quint16 productId)
 
     setWindowTitle("Produk Baru");
     ui->idEdit->clear();
+    // The copy starts without purchases of its own
+    ui->averageCostEdit->setText(QLocale().toString(0));
+    ui->lastPurchaseCostEdit->setText(QLocale().toString(0));
     duplicateAction->setEnabled(false);
     removeAction->setEnabled(false);
+    purchaseAction->setEnabled(false);
 
     QTimer::singleShot(0, ui->nameEdit, SLOT(setFocus()));
     QTimer::singleShot(0, ui->nameEdit, SLOT(selectAll()));
@@ -611,6 +690,30 @@ bool ProductEditor::duplicateFrom(quint16 productId)
     return true;
 }
 
+void ProductEditor::reset()
+{
+    id = 0;
+
+    ui->tabWidget->setCurrentIndex(0);
+    ui->idEdit->clear();
+    ui->nameEdit->clear();
+    ui->typeComboBox->setCurrentIndex(ui->typeComboBox->findData(Product::Type::Stocked));
+    ui->statusComboBox->setCurrentIndex(1);
+    uomModel->setItems(QList<UomModel::Item>());
+    ui->baseUomEdit->clear();
+    uomModel->updateBaseUom(QString());
+    priceModel->setItems(QList<PriceModel::Item>());
+    ui->costingMethodComboBox->setCurrentIndex(ui->costingMethodComboBox->findData(Product::CostingMethod::Average));
+    ui->manualCostEdit->setText(QLocale().toString(0));
+    ui->averageCostEdit->setText(QLocale().toString(0));
+    ui->lastPurchaseCostEdit->setText(QLocale().toString(0));
+
+    duplicateAction->setEnabled(false);
+    removeAction->setEnabled(false);
+    purchaseAction->setEnabled(false);
+    setWindowTitle("Produk Baru");
+}
+
 bool ProductEditor::eventFilter(QObject *object, QEvent *event)
 {
     if (object == ui->uomTableView) {
@@ -639,9 +742,56 @@ bool ProductEditor::eventFilter(QObject *object, QEvent *event)
     return QWidget::eventFilter(object, event);
 }
 
+namespace {
+
+// "?,?,?" for an IN list
+QString listPlaceholders(int count)
+{
+    QString result;
+    result.reserve(count * 2);
+    for (int i = 0; i < count; i++)
+        result += i ? ",?" : "?";
+    return result;
+}
+
+// "(?,?),(?,?)" for a multi-row insert
+QString valuesPlaceholders(int rows, int columns)
+{
+    QString row = QString("(%1)").arg(listPlaceholders(columns));
+    QStringList result;
+    result.reserve(rows);
+    for (int i = 0; i < rows; i++)
+        result << row;
+    return result.join(',');
+}
+
+// "case id when ? then ? ... end", binds an id and its value per row
+QString caseById(int rows)
+{
+    QString result("case id");
+    for (int i = 0; i < rows; i++)
+        result += " when ? then ?";
+    result += " end";
+    return result;
+}
+
+// Lowest id a multi-row insert can have given: MySQL reports the statement's first
+// id, SQLite its last one, and SQLite's rows of one statement are consecutive
+quint64 firstInsertedId(const QSqlQuery& q, int rows)
+{
+    quint64 id = q.lastInsertId().toULongLong();
+    if (q.driver() && q.driver()->dbmsType() == QSqlDriver::SQLite)
+        id = id >= quint64(rows) ? id - rows + 1 : 1;
+    return id;
+}
+
+}
+
 void ProductEditor::save()
 {
-    QSqlDatabase db = QSqlDatabase::database();
+    SIMS_TRACE_SCOPE("ProductEditor::save");
+
+    QSqlDatabase db = ConnectionPool::instance()->database();
     QSqlQuery q(db);
 
     bool isNewRecord = id == 0;
@@ -650,10 +800,7 @@ void ProductEditor::save()
     bool active = ui->statusComboBox->currentIndex();
     QString baseUom = ui->baseUomEdit->text().trimmed();
     quint8 costingMethod = ui->costingMethodComboBox->currentData().toInt();
-    int cost = 0;
     int manualCost = QLocale().toInt(ui->manualCostEdit->text());
-    int averageCost = QLocale().toInt(ui->averageCostEdit->text());
-    int lastPurchaseCost = QLocale().toInt(ui->lastPurchaseCostEdit->text());
 
     if (name.isEmpty()) {
         ui->nameEdit->setFocus();
@@ -670,7 +817,7 @@ void ProductEditor::save()
         q.bindValue(0, name);
         q.bindValue(1, id);
     }
-    q.exec();
+    Sql::exec(q);
     q.next();
     if (q.value(0).toInt() > 0) {
         ui->nameEdit->setFocus();
@@ -686,15 +833,28 @@ void ProductEditor::save()
         return;
     }
 
+    // Overlapping tiers would make the price of a quantity ambiguous at the till
+    QVector<PriceTable::Tier> tiers;
+    for (const PriceModel::Item& item: priceModel->items) {
+        if (!item.isNull())
+            tiers << item.tier();
+    }
+    QStringList priceProblems = PriceTable(tiers).problems();
+    if (!priceProblems.isEmpty()) {
+        ui->tabWidget->setCurrentWidget(ui->generalTab);
+        ui->priceTableView->setFocus();
+        QMessageBox::warning(0, "Peringatan", "Tingkat harga tidak valid:\n" + priceProblems.join("\n"));
+        return;
+    }
+
+    // Average and last purchase costs belong to the CostingEngine, the editor only picks which one is the cost
+    QString costExpression = ":cost";
     switch (costingMethod) {
-    case Product::CostingMethod::Manual:
-        cost = manualCost;
-        break;
     case Product::CostingMethod::Average:
-        cost = averageCost;
+        costExpression = "averageCost";
         break;
     case Product::CostingMethod::Last:
-        cost = lastPurchaseCost;
+        costExpression = "lastPurchaseCost";
         break;
     }
 
@@ -706,18 +866,21 @@ void ProductEditor::save()
     db.transaction();
 
     if (id == 0) {
+        // Nothing has been received yet, so only a manual cost can be set
         q.prepare("insert into products"
-                  "( name, type, active, baseUom, costingMethod, cost, manualCost, averageCost, lastPurchaseCost)"
+                  "( name, type, active, baseUom, costingMethod, cost, manualCost)"
                   " values"
-                  "(:name,:type,:active,:baseUom,:costingMethod,:cost,:manualCost,:averageCost,:lastPurchaseCost)");
+                  "(:name,:type,:active,:baseUom,:costingMethod,:cost,:manualCost)");
+        q.bindValue(":cost", costingMethod == Product::CostingMethod::Manual ? manualCost : 0);
     }
     else {
-        q.prepare("update products set"
-                  " name=:name, type=:type, active=:active, baseUom:=baseUom,"
-                  " costingMethod=:costingMethod, cost=:cost,"
-                  " manualCost=:manualCost, averageCost=:averageCost, lastPurchaseCost=:lastPurchaseCost"
-                  " where id=:id");
+        q.prepare(QString("update products set"
+                          " name=:name, type=:type, active=:active, baseUom=:baseUom,"
+                          " costingMethod=:costingMethod, cost=%1, manualCost=:manualCost"
+                          " where id=:id").arg(costExpression));
         q.bindValue(":id", id);
+        if (costingMethod == Product::CostingMethod::Manual)
+            q.bindValue(":cost", manualCost);
     }
 
     q.bindValue(":name", name);
@@ -725,12 +888,9 @@ void ProductEditor::save()
     q.bindValue(":active", active);
     q.bindValue(":baseUom", baseUom);
     q.bindValue(":costingMethod", costingMethod);
-    q.bindValue(":cost", cost);
     q.bindValue(":manualCost", manualCost);
-    q.bindValue(":averageCost", averageCost);
-    q.bindValue(":lastPurchaseCost", lastPurchaseCost);
 
-    if (!q.exec()) {
+    if (!Sql::exec(q)) {
         qDebug() << __FILE__ << __LINE__ << q.lastError().text();
         db.rollback();
         return;
@@ -743,90 +903,177 @@ void ProductEditor::save()
         ui->idEdit->setText(idText);
     }
 
-    QSqlQuery q2(db);
+    // Every statement below covers all rows of its table, so a save costs the same
+    // number of round trips however many units and prices the product has
+    QList<UomModel::Item*> newUoms, updatedUoms;
     for (UomModel::Item &item: uomModel->items) {
-        if (item.isNull())
-            continue;
+        if (!item.isNull())
+            (item.id ? updatedUoms : newUoms) << &item;
+    }
 
-        if (!item.id) {
-            q2.prepare("insert into product_uoms(productId,name,quantity)"
-                       " values(:productId,:name,:quantity)");
-            q2.bindValue(":productId", id);
+    QList<PriceModel::Item*> newPrices, updatedPrices;
+    for (PriceModel::Item &item: priceModel->items) {
+        if (!item.isNull())
+            (item.id ? updatedPrices : newPrices) << &item;
+    }
+
+    QSqlQuery q2(db);
+    if (!uomModel->deletedIds.isEmpty()) {
+        q2.prepare(QString("delete from product_uoms where id in (%1)").arg(listPlaceholders(uomModel->deletedIds.size())));
+        for (quint64 deletedId: uomModel->deletedIds)
+            q2.addBindValue(deletedId);
+        if (!Sql::exec(q2)) {
+            qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
+            db.rollback();
+            return;
         }
-        else {
-            q2.prepare("update product_uoms set name=:name, quantity=:quantity where id=:id");
-            q2.bindValue(":id", item.id);
+    }
+
+    if (!priceModel->deletedIds.isEmpty()) {
+        q2.prepare(QString("delete from product_prices where id in (%1)").arg(listPlaceholders(priceModel->deletedIds.size())));
+        for (quint64 deletedId: priceModel->deletedIds)
+            q2.addBindValue(deletedId);
+        if (!Sql::exec(q2)) {
+            qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
+            db.rollback();
+            return;
+        }
+    }
+
+    if (!updatedUoms.isEmpty()) {
+        QString whenThen = caseById(updatedUoms.size());
+        q2.prepare(QString("update product_uoms set name=%1, quantity=%1 where id in (%2)")
+                   .arg(whenThen, listPlaceholders(updatedUoms.size())));
+        for (UomModel::Item* item: updatedUoms) {
+            q2.addBindValue(item->id);
+            q2.addBindValue(item->name);
+        }
+        for (UomModel::Item* item: updatedUoms) {
+            q2.addBindValue(item->id);
+            q2.addBindValue(item->quantity);
         }
-        q2.bindValue(":name", item.name);
-        q2.bindValue(":quantity", item.quantity);
-        if (!q2.exec()) {
+        for (UomModel::Item* item: updatedUoms)
+            q2.addBindValue(item->id);
+        if (!Sql::exec(q2)) {
             qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
             db.rollback();
             return;
         }
+    }
 
-        if (!item.id)
-            item.id = q2.lastInsertId().toULongLong();
+    if (!updatedPrices.isEmpty()) {
+        static const char* const columns[] = {
+            "quantityMin", "quantityMax", "price1Min", "price1Max", "price2Min", "price2Max", "price3Min", "price3Max"
+        };
+
+        QString whenThen = caseById(updatedPrices.size());
+        QStringList assignments;
+        for (const char* column: columns)
+            assignments << QString("%1=%2").arg(column, whenThen);
+        q2.prepare(QString("update product_prices set %1 where id in (%2)")
+                   .arg(assignments.join(", "), listPlaceholders(updatedPrices.size())));
+        for (int column = 0; column < 8; column++) {
+            for (PriceModel::Item* item: updatedPrices) {
+                q2.addBindValue(item->id);
+                q2.addBindValue(item->values().at(column));
+            }
+        }
+        for (PriceModel::Item* item: updatedPrices)
+            q2.addBindValue(item->id);
+        if (!Sql::exec(q2)) {
+            qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
+            db.rollback();
+            return;
+        }
     }
 
-    q2.clear();
-    for (PriceModel::Item &item: priceModel->items) {
-        if (item.isNull())
-            continue;
+    quint64 firstUomId = 0;
+    quint64 firstPriceId = 0;
 
-        if (!item.id) {
-            q2.prepare("insert into product_prices"
-                       "( productId, quantityMin, quantityMax, price1Min, price1Max, price2Min, price2Max, price3Min, price3Max) values"
-                       "(:productId,:quantityMin,:quantityMax,:price1Min,:price1Max,:price2Min,:price2Max,:price3Min,:price3Max)");
-            q2.bindValue(":productId", id);
+    if (!newUoms.isEmpty()) {
+        q2.prepare(QString("insert into product_uoms(productId,name,quantity) values %1")
+                   .arg(valuesPlaceholders(newUoms.size(), 3)));
+        for (UomModel::Item* item: newUoms) {
+            q2.addBindValue(id);
+            q2.addBindValue(item->name);
+            q2.addBindValue(item->quantity);
         }
-        else {
-            q2.prepare("update product_prices set"
-                       " quantityMin=:quantityMin, quantityMax=:quantityMax,"
-                       " price1Min=:price1Min, price1Max=:price1Max,"
-                       " price2Min=:price2Min, price2Max=:price2Max,"
-                       " price3Min=:price3Min, price3Max=:price3Max"
-                       " where id=:id");
-            q2.bindValue(":id", item.id);
-        }
-        q2.bindValue(":quantityMin", item.quantity.first);
-        q2.bindValue(":quantityMax", item.quantity.second);
-        q2.bindValue(":price1Min", item.price1.first);
-        q2.bindValue(":price1Max", item.price1.second);
-        q2.bindValue(":price2Min", item.price2.first);
-        q2.bindValue(":price2Max", item.price2.second);
-        q2.bindValue(":price3Min", item.price3.first);
-        q2.bindValue(":price3Max", item.price3.second);
-        if (!q2.exec()) {
+        if (!Sql::exec(q2)) {
             qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
             db.rollback();
             return;
         }
+        firstUomId = firstInsertedId(q2, newUoms.size());
+    }
 
-        if (!item.id)
-            item.id = q2.lastInsertId().toULongLong();
+    if (!newPrices.isEmpty()) {
+        q2.prepare(QString("insert into product_prices"
+                           "(productId, quantityMin, quantityMax, price1Min, price1Max, price2Min, price2Max, price3Min, price3Max)"
+                           " values %1").arg(valuesPlaceholders(newPrices.size(), 9)));
+        for (PriceModel::Item* item: newPrices) {
+            q2.addBindValue(id);
+            for (quint64 value: item->values())
+                q2.addBindValue(value);
+        }
+        if (!Sql::exec(q2)) {
+            qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
+            db.rollback();
+            return;
+        }
+        firstPriceId = firstInsertedId(q2, newPrices.size());
     }
 
-    q2.clear();
-    for (qulonglong id: uomModel->deletedIds) {
-        q2.prepare("delete from product_uoms where id=?");
-        q2.bindValue(0, id);
-        if (!q2.exec()) {
+    // A multi-row insert only reports one id, so the new ids are read back. Only rows from this
+    // insert's first id on are candidates, and each must hold exactly the values this editor
+    // wrote, so a row another client added to the product meanwhile is never taken for ours.
+    if (!newUoms.isEmpty()) {
+        q2.prepare("select id, name, quantity from product_uoms where productId=? and id>=? order by id");
+        q2.addBindValue(id);
+        q2.addBindValue(firstUomId);
+        if (!Sql::exec(q2)) {
             qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
             db.rollback();
             return;
         }
+
+        QList<UomModel::Item*> unmatched = newUoms;
+        while (q2.next() && !unmatched.isEmpty()) {
+            for (int i = 0; i < unmatched.size(); i++) {
+                UomModel::Item* item = unmatched.at(i);
+                if (item->name == q2.value(1).toString() && item->quantity == q2.value(2).toULongLong()) {
+                    item->id = q2.value(0).toULongLong();
+                    unmatched.removeAt(i);
+                    break;
+                }
+            }
+        }
     }
 
-    q2.clear();
-    for (qulonglong id: priceModel->deletedIds) {
-        q2.prepare("delete from product_prices where id=?");
-        q2.bindValue(0, id);
-        if (!q2.exec()) {
+    if (!newPrices.isEmpty()) {
+        q2.prepare("select id, quantityMin, quantityMax, price1Min, price1Max, price2Min, price2Max, price3Min, price3Max"
+                   " from product_prices where productId=? and id>=? order by id");
+        q2.addBindValue(id);
+        q2.addBindValue(firstPriceId);
+        if (!Sql::exec(q2)) {
             qDebug() << __FILE__ << __LINE__ << q2.lastError().text();
             db.rollback();
             return;
         }
+
+        QList<PriceModel::Item*> unmatched = newPrices;
+        while (q2.next() && !unmatched.isEmpty()) {
+            QVector<quint64> values;
+            for (int column = 1; column <= 8; column++)
+                values << q2.value(column).toULongLong();
+
+            for (int i = 0; i < unmatched.size(); i++) {
+                if (unmatched.at(i)->values() == values) {
+                    unmatched.at(i)->id = q2.value(0).toULongLong();
+                    unmatched.removeAt(i);
+                    break;
+                }
+            }
+        }
     }
 
     if (!db.commit()) {
@@ -838,8 +1085,11 @@ void ProductEditor::save()
     if (isNewRecord) {
         duplicateAction->setEnabled(true);
         removeAction->setEnabled(true);
+        purchaseAction->setEnabled(true);
     }
 
+    PriceBook::instance()->invalidate(id);
+
     emit saved(id);
 }
 
@@ -848,18 +1098,78 @@ void ProductEditor::remove()
     if (QMessageBox::question(0, "Konfirmasi", "Hapus produk?", "&Ya", "&Tidak"))
         return;
 
-    QSqlDatabase db = QSqlDatabase::database();
+    SIMS_TRACE_SCOPE("ProductEditor::remove");
+
+    QSqlDatabase db = ConnectionPool::instance()->database();
     QSqlQuery q(db);
     q.prepare("delete from products where id=?");
     q.bindValue(0, id);
-    if (!q.exec()) {
+    if (!Sql::exec(q)) {
         qDebug() << __FILE__ << __LINE__ << db.lastError().text();
         return;
     }
 
+    PriceBook::instance()->invalidate(id);
+
     emit removed(id);
 }
 
+void ProductEditor::recordPurchase()
+{
+    if (!id)
+        return;
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Catat Pembelian");
+    QLineEdit* quantityEdit = new QLineEdit(&dialog);
+    QLineEdit* unitCostEdit = new QLineEdit(&dialog);
+    QLineEdit* referenceEdit = new QLineEdit(&dialog);
+    referenceEdit->setMaxLength(50);
+    referenceEdit->setPlaceholderText("No. faktur");
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(&dialog);
+    buttonBox->addButton("&Simpan", QDialogButtonBox::AcceptRole);
+    buttonBox->addButton("&Batal", QDialogButtonBox::RejectRole);
+    connect(buttonBox, SIGNAL(accepted()), &dialog, SLOT(accept()));
+    connect(buttonBox, SIGNAL(rejected()), &dialog, SLOT(reject()));
+
+    QFormLayout* layout = new QFormLayout(&dialog);
+    layout->addRow(QString("Kwantitas (%1):").arg(ui->baseUomEdit->text().trimmed()), quantityEdit);
+    layout->addRow("Harga beli satuan:", unitCostEdit);
+    layout->addRow("Referensi:", referenceEdit);
+    layout->addRow(buttonBox);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    bool quantityOk, unitCostOk;
+    quint64 quantity = QLocale().toULongLong(quantityEdit->text().trimmed(), &quantityOk);
+    quint64 unitCost = QLocale().toULongLong(unitCostEdit->text().trimmed(), &unitCostOk);
+    if (!quantityOk || !quantity || !unitCostOk) {
+        QMessageBox::warning(0, "Peringatan", "Kwantitas dan harga beli harus berupa angka!");
+        return;
+    }
+
+    if (!CostingEngine::postReceipt(id, quantity, unitCost, referenceEdit->text().trimmed())) {
+        QMessageBox::warning(0, "Peringatan", "Pembelian gagal dicatat!");
+        return;
+    }
+
+    // Only the costs are read back, unsaved changes in the editor stay
+    QSqlQuery q(ConnectionPool::instance()->database());
+    q.prepare("select averageCost, lastPurchaseCost from products where id=?");
+    q.addBindValue(id);
+    if (Sql::exec(q) && q.next()) {
+        ui->averageCostEdit->setText(QLocale().toString(q.value(0).toULongLong()));
+        ui->lastPurchaseCostEdit->setText(QLocale().toString(q.value(1).toULongLong()));
+    }
+    else {
+        qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+    }
+
+    emit saved(id);
+}
+
 void ProductEditor::onDuplicateActionTriggered()
 {
     if (id)
@@ -31,6 +31,8 @@ public:
 
     bool load(quint16 productId);
     bool duplicateFrom(quint16 productId);
+    // Back to an empty new product, so a closed editor can be used again
+    void reset();
 
 signals:
     void duplicateRequested(quint16 id);
@@ -40,6 +42,7 @@ signals:
 public slots:
     void save();
     void remove();
+    void recordPurchase();
 
 private slots:
     void onDuplicateActionTriggered();
@@ -47,6 +50,7 @@ private slots:
 private:
     QAction* duplicateAction;
     QAction* removeAction;
+    QAction* purchaseAction;
 };
 
 
@@ -0,0 +1,422 @@
+#include "productexporter.h"
+#include "checksum.h"
+#include "productcatalogreader.h"
+#include "product.h"
+#include "trace.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+#include <QScopedPointer>
+
+namespace {
+
+const int BufferSize = 64 * 1024;
+// "Harga Beli", the only column holding a single number
+const int CostColumn = 4;
+
+// Buffers writes to a file and keeps the first error
+class BufferedFile
+{
+public:
+    explicit BufferedFile(QFile* file)
+        : _file(file)
+        , _ok(true)
+    {
+        _buffer.reserve(BufferSize);
+    }
+
+    void write(const QByteArray& data)
+    {
+        if (_buffer.size() + data.size() > BufferSize)
+            flush();
+        if (data.size() > BufferSize)
+            _ok = _ok && _file->write(data) == data.size();
+        else
+            _buffer += data;
+    }
+
+    bool flush()
+    {
+        if (!_buffer.isEmpty()) {
+            _ok = _ok && _file->write(_buffer) == _buffer.size();
+            _buffer.clear();
+        }
+        return _ok;
+    }
+
+    QFile* file() const { return _file; }
+
+private:
+    QFile* _file;
+    QByteArray _buffer;
+    bool _ok;
+};
+
+class RowWriter
+{
+public:
+    virtual ~RowWriter() {}
+    virtual bool begin() = 0;
+    virtual void writeRow(const QStringList& fields) = 0;
+    virtual bool finish() = 0;
+};
+
+class CsvWriter : public RowWriter
+{
+public:
+    explicit CsvWriter(QFile* file) : _out(file) {}
+
+    bool begin()
+    {
+        // The byte order mark makes spreadsheet programs read the file as UTF-8
+        _out.write("\xEF\xBB\xBF");
+        return true;
+    }
+
+    void writeRow(const QStringList& fields)
+    {
+        QByteArray line;
+        for (int i = 0; i < fields.size(); i++) {
+            if (i)
+                line += ',';
+            QByteArray field = fields.at(i).toUtf8();
+            if (field.contains(',') || field.contains('"') || field.contains('\n') || field.contains('\r'))
+                line += '"' + field.replace("\"", "\"\"") + '"';
+            else
+                line += field;
+        }
+        line += "\r\n";
+        _out.write(line);
+    }
+
+    bool finish()
+    {
+        return _out.flush();
+    }
+
+private:
+    BufferedFile _out;
+};
+
+// A single sheet workbook in a zip without compression.
+// Each part's header is written with a zero checksum and size and patched
+// once the part is complete, so the sheet never has to be held in memory.
+class XlsxWriter : public RowWriter
+{
+public:
+    // Cells of the numeric columns that hold plain digits are written as numbers,
+    // every other cell stays text so names like "0812" keep their leading zero
+    XlsxWriter(QFile* file, const QVector<int>& numericColumns)
+        : _out(file)
+        , _numericColumns(numericColumns)
+    {
+        QDateTime now = QDateTime::currentDateTime();
+        _dosTime = quint16((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+        _dosDate = quint16(((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day());
+    }
+
+    bool begin()
+    {
+        writePart("[Content_Types].xml",
+                  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                  "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+                  "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+                  "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+                  "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+                  "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+                  "</Types>");
+        writePart("_rels/.rels",
+                  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                  "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+                  "</Relationships>");
+        writePart("xl/workbook.xml",
+                  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                  "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+                  " xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+                  "<sheets><sheet name=\"Produk\" sheetId=\"1\" r:id=\"rId1\"/></sheets>"
+                  "</workbook>");
+        writePart("xl/_rels/workbook.xml.rels",
+                  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                  "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+                  "</Relationships>");
+
+        beginEntry("xl/worksheets/sheet1.xml");
+        writeData("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                  "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>");
+        return _out.flush();
+    }
+
+    void writeRow(const QStringList& fields)
+    {
+        QByteArray row("<row>");
+        for (int column = 0; column < fields.size(); column++) {
+            const QString& field = fields.at(column);
+            bool isNumber = _numericColumns.contains(column) && !field.isEmpty() && field.size() < 16;
+            for (int i = 0; i < field.size() && isNumber; i++)
+                isNumber = field.at(i).isDigit() && field.at(i).unicode() < 128;
+
+            if (isNumber)
+                row += "<c><v>" + field.toLatin1() + "</v></c>";
+            else if (field.isEmpty())
+                row += "<c/>";
+            else
+                row += "<c t=\"inlineStr\"><is><t>" + escaped(field) + "</t></is></c>";
+        }
+        row += "</row>";
+        writeData(row);
+    }
+
+    bool finish()
+    {
+        writeData("</sheetData></worksheet>");
+        if (!endEntry())
+            return false;
+
+        QByteArray directory;
+        for (const Entry& entry: _entries) {
+            appendLe32(directory, 0x02014b50);
+            appendLe16(directory, 20);
+            appendLe16(directory, 20);
+            appendLe16(directory, 0x0800);
+            appendLe16(directory, 0);
+            appendLe16(directory, _dosTime);
+            appendLe16(directory, _dosDate);
+            appendLe32(directory, entry.crc);
+            appendLe32(directory, entry.size);
+            appendLe32(directory, entry.size);
+            appendLe16(directory, quint16(entry.name.size()));
+            appendLe16(directory, 0);
+            appendLe16(directory, 0);
+            appendLe16(directory, 0);
+            appendLe16(directory, 0);
+            appendLe32(directory, 0);
+            appendLe32(directory, entry.offset);
+            directory += entry.name;
+        }
+
+        quint32 directoryOffset = quint32(_out.file()->pos());
+        QByteArray end;
+        appendLe32(end, 0x06054b50);
+        appendLe16(end, 0);
+        appendLe16(end, 0);
+        appendLe16(end, quint16(_entries.size()));
+        appendLe16(end, quint16(_entries.size()));
+        appendLe32(end, quint32(directory.size()));
+        appendLe32(end, directoryOffset);
+        appendLe16(end, 0);
+
+        _out.write(directory);
+        _out.write(end);
+        return _out.flush();
+    }
+
+private:
+    struct Entry
+    {
+        QByteArray name;
+        quint32 offset;
+        quint32 crc;
+        quint32 size;
+    };
+
+    static void appendLe16(QByteArray& data, quint16 value)
+    {
+        data += char(value & 0xFF);
+        data += char(value >> 8);
+    }
+
+    static void appendLe32(QByteArray& data, quint32 value)
+    {
+        appendLe16(data, quint16(value & 0xFFFF));
+        appendLe16(data, quint16(value >> 16));
+    }
+
+    static QByteArray escaped(const QString& text)
+    {
+        QString result = text.toHtmlEscaped();
+        // Control characters are not allowed in XML at all
+        for (QChar& c: result) {
+            if (c.unicode() < 0x20 && c != '\t' && c != '\n' && c != '\r')
+                c = QChar(' ');
+        }
+        return result.toUtf8();
+    }
+
+    void beginEntry(const QByteArray& name)
+    {
+        _out.flush();
+
+        Entry entry;
+        entry.name = name;
+        entry.offset = quint32(_out.file()->pos());
+        entry.crc = 0;
+        entry.size = 0;
+        _entries << entry;
+
+        QByteArray header;
+        appendLe32(header, 0x04034b50);
+        appendLe16(header, 20);
+        appendLe16(header, 0x0800);
+        appendLe16(header, 0);
+        appendLe16(header, _dosTime);
+        appendLe16(header, _dosDate);
+        appendLe32(header, 0);
+        appendLe32(header, 0);
+        appendLe32(header, 0);
+        appendLe16(header, quint16(name.size()));
+        appendLe16(header, 0);
+        header += name;
+        _out.write(header);
+    }
+
+    void writeData(const QByteArray& data)
+    {
+        Entry& entry = _entries.last();
+        entry.crc = Checksum::crc32(entry.crc, data.constData(), data.size());
+        entry.size += quint32(data.size());
+        _out.write(data);
+    }
+
+    bool endEntry()
+    {
+        if (!_out.flush())
+            return false;
+
+        const Entry& entry = _entries.last();
+        QByteArray sizes;
+        appendLe32(sizes, entry.crc);
+        appendLe32(sizes, entry.size);
+        appendLe32(sizes, entry.size);
+
+        // Checksum and sizes sit 14 bytes into the local header
+        QFile* file = _out.file();
+        qint64 end = file->pos();
+        return file->seek(entry.offset + 14)
+            && file->write(sizes) == sizes.size()
+            && file->seek(end);
+    }
+
+    void writePart(const QByteArray& name, const QByteArray& content)
+    {
+        beginEntry(name);
+        writeData(content);
+        endEntry();
+    }
+
+    BufferedFile _out;
+    QVector<int> _numericColumns;
+    QList<Entry> _entries;
+    quint16 _dosTime;
+    quint16 _dosDate;
+};
+
+// Same forms as the editor and the importer: "n", "a-b" and ">=n"
+QString quantityText(quint64 min, quint64 max)
+{
+    if (!max)
+        return QString(">=%1").arg(min);
+    if (min == max)
+        return QString::number(min);
+    return QString("%1-%2").arg(min).arg(max);
+}
+
+QString priceText(quint64 min, quint64 max)
+{
+    if (!min && !max)
+        return QString();
+    if (min == max)
+        return QString::number(max);
+    return QString("%1-%2").arg(min).arg(max);
+}
+
+}
+
+ProductExporter::Format ProductExporter::formatForPath(const QString& path)
+{
+    return QFileInfo(path).suffix().toLower() == "xlsx" ? Xlsx : Csv;
+}
+
+bool ProductExporter::exportTo(const QString& path, Format format, const ProgressCallback& progress, QString* error)
+{
+    SIMS_TRACE_SCOPE("ProductExporter::exportTo");
+
+    auto fail = [error](const QString& text) {
+        if (error)
+            *error = text;
+        return false;
+    };
+
+    ProductCatalogReader reader;
+    int total = 0;
+    if (!reader.count(&total))
+        return fail(reader.errorString());
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return fail(QString("File %1 tidak dapat ditulis.").arg(path));
+
+    QScopedPointer<RowWriter> writer;
+    if (format == Xlsx)
+        writer.reset(new XlsxWriter(&file, QVector<int>() << CostColumn));
+    else
+        writer.reset(new CsvWriter(&file));
+
+    auto abort = [&file, &fail](const QString& text) {
+        file.close();
+        file.remove();
+        return fail(text);
+    };
+
+    if (!writer->begin())
+        return abort(file.errorString());
+
+    writer->writeRow(QStringList() << "Nama" << "Jenis" << "Status" << "Satuan" << "Harga Beli" << "Satuan Lain" << "Harga");
+
+    int done = 0;
+    QVector<ProductCatalogReader::Entry> page;
+    forever {
+        if (!reader.next(&page))
+            return abort(reader.errorString());
+        if (page.isEmpty())
+            break;
+
+        for (const ProductCatalogReader::Entry& entry: page) {
+            QStringList uoms;
+            for (const QPair<QString, quint64>& uom: entry.uoms)
+                uoms << QString("%1=%2").arg(uom.first, QString::number(uom.second));
+
+            QStringList tiers;
+            for (const PriceTable::Tier& tier: entry.tiers) {
+                tiers << QString("%1=%2/%3/%4").arg(quantityText(tier.quantityMin, tier.quantityMax),
+                                                    priceText(tier.priceMin[0], tier.priceMax[0]),
+                                                    priceText(tier.priceMin[1], tier.priceMax[1]),
+                                                    priceText(tier.priceMin[2], tier.priceMax[2]));
+            }
+
+            writer->writeRow(QStringList()
+                             << entry.name
+                             << Product::typeString(Product::Type(entry.type))
+                             << (entry.active ? "Aktif" : "Nonaktif")
+                             << entry.baseUom
+                             << QString::number(entry.manualCost)
+                             << uoms.join('|')
+                             << tiers.join('|'));
+        }
+
+        done += page.size();
+        if (progress && !progress(done, total))
+            return abort("Ekspor dibatalkan.");
+    }
+
+    if (!writer->finish())
+        return abort(file.errorString());
+
+    file.close();
+    return true;
+}
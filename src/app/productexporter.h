@@ -0,0 +1,30 @@
+#ifndef PRODUCTEXPORTER_H
+#define PRODUCTEXPORTER_H
+
+#include <QString>
+#include <functional>
+
+// Writes every product with its units and price tiers to a CSV or XLSX file,
+// in the columns ProductImporter reads. Products come from a
+// ProductCatalogReader a page at a time and are written through a fixed
+// size buffer, so memory use does not grow with the catalog.
+class ProductExporter
+{
+public:
+    enum Format {
+        Csv,
+        Xlsx
+    };
+
+    // Called from the exporting thread after every page, returning false cancels
+    typedef std::function<bool(int done, int total)> ProgressCallback;
+
+    // Connections come from the ConnectionPool, for the calling thread.
+    // A failed or cancelled export removes the partly written file.
+    static bool exportTo(const QString& path, Format format,
+                         const ProgressCallback& progress = ProgressCallback(), QString* error = 0);
+
+    static Format formatForPath(const QString& path);
+};
+
+#endif // PRODUCTEXPORTER_H
@@ -0,0 +1,155 @@
+#include "productimportdialog.h"
+
+#include <QLineEdit>
+#include <QProgressBar>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QLabel>
+#include <QFileDialog>
+#include <QFile>
+#include <QTextStream>
+#include <QMessageBox>
+#include <QBoxLayout>
+#include <QtConcurrentRun>
+
+ProductImportDialog::ProductImportDialog(QWidget *parent)
+    : QDialog(parent)
+    , _importedCount(0)
+{
+    setWindowTitle("Impor Produk");
+
+    _pool.setMaxThreadCount(1);
+
+    _pathEdit = new QLineEdit(this);
+    _pathEdit->setPlaceholderText("File CSV atau TSV");
+    _browseButton = new QPushButton("&Pilih...", this);
+    connect(_browseButton, SIGNAL(clicked(bool)), SLOT(browse()));
+
+    QLabel* formatLabel = new QLabel("Satu baris per produk: nama, jenis, status, satuan, harga beli,"
+                                     " satuan lain (Lusin=12|Dus=48),"
+                                     " harga (1-11=10000/9500/9000|&gt;=12=9000/8500/8000).", this);
+    formatLabel->setWordWrap(true);
+
+    _progressBar = new QProgressBar(this);
+    _progressBar->setValue(0);
+
+    _reportEdit = new QPlainTextEdit(this);
+    _reportEdit->setReadOnly(true);
+
+    _importButton = new QPushButton("&Impor", this);
+    _importButton->setDefault(true);
+    connect(_importButton, SIGNAL(clicked(bool)), SLOT(startImport()));
+
+    _saveReportButton = new QPushButton("&Simpan Laporan", this);
+    _saveReportButton->setEnabled(false);
+    connect(_saveReportButton, SIGNAL(clicked(bool)), SLOT(saveReport()));
+
+    _closeButton = new QPushButton("&Tutup", this);
+    connect(_closeButton, SIGNAL(clicked(bool)), SLOT(reject()));
+
+    connect(&_watcher, SIGNAL(finished()), SLOT(_onFinished()));
+
+    QBoxLayout* pathLayout = new QHBoxLayout;
+    pathLayout->addWidget(_pathEdit, 1);
+    pathLayout->addWidget(_browseButton);
+
+    QBoxLayout* buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(_saveReportButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(_importButton);
+    buttonLayout->addWidget(_closeButton);
+
+    QBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(pathLayout);
+    mainLayout->addWidget(formatLabel);
+    mainLayout->addWidget(_progressBar);
+    mainLayout->addWidget(_reportEdit, 1);
+    mainLayout->addLayout(buttonLayout);
+
+    resize(600, 400);
+}
+
+void ProductImportDialog::browse()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Pilih File", _pathEdit->text(),
+                                                "CSV / TSV (*.csv *.tsv *.txt);;Semua File (*)");
+    if (!path.isEmpty())
+        _pathEdit->setText(path);
+}
+
+void ProductImportDialog::startImport()
+{
+    QString path = _pathEdit->text().trimmed();
+    if (path.isEmpty() || !QFile::exists(path)) {
+        _pathEdit->setFocus();
+        QMessageBox::warning(0, "Peringatan", "File tidak ditemukan!");
+        return;
+    }
+
+    _pathEdit->setEnabled(false);
+    _browseButton->setEnabled(false);
+    _importButton->setEnabled(false);
+    _saveReportButton->setEnabled(false);
+    _closeButton->setEnabled(false);
+    _reportEdit->setPlainText("Membaca file...");
+    _progressBar->setRange(0, 0);
+
+    // Progress comes from the import thread, it is handed over through the event loop
+    ProductImporter::ProgressCallback progress = [this](int done, int total) {
+        QMetaObject::invokeMethod(this, "_onProgress", Qt::QueuedConnection, Q_ARG(int, done), Q_ARG(int, total));
+    };
+
+    _watcher.setFuture(QtConcurrent::run(&_pool, [path, progress]() {
+        return ProductImporter::import(path, ProductImporter::Options(), progress);
+    }));
+}
+
+void ProductImportDialog::saveReport()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Simpan Laporan", QString(), "Teks (*.txt)");
+    if (path.isEmpty())
+        return;
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        QMessageBox::warning(0, "Peringatan", "Laporan gagal disimpan!");
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << ProductImporter::report(_result) << '\n';
+}
+
+void ProductImportDialog::reject()
+{
+    // An import in progress commits batch by batch, it has to run to the end
+    if (_watcher.isRunning())
+        return;
+
+    QDialog::reject();
+}
+
+void ProductImportDialog::_onProgress(int done, int total)
+{
+    _progressBar->setRange(0, total);
+    _progressBar->setValue(done);
+    _reportEdit->setPlainText(QString("Menyimpan %1 dari %2 produk...")
+                              .arg(QLocale().toString(done), QLocale().toString(total)));
+}
+
+void ProductImportDialog::_onFinished()
+{
+    _result = _watcher.result();
+    _importedCount += _result.imported;
+
+    _progressBar->setRange(0, 1);
+    _progressBar->setValue(1);
+    _reportEdit->setPlainText(ProductImporter::report(_result));
+
+    _pathEdit->setEnabled(true);
+    _browseButton->setEnabled(true);
+    _importButton->setEnabled(true);
+    _saveReportButton->setEnabled(!_result.errors.isEmpty() || !_result.failure.isEmpty());
+    _closeButton->setEnabled(true);
+}
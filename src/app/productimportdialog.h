@@ -0,0 +1,51 @@
+#ifndef PRODUCTIMPORTDIALOG_H
+#define PRODUCTIMPORTDIALOG_H
+
+#include "productimporter.h"
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QThreadPool>
+
+class QLineEdit;
+class QProgressBar;
+class QPlainTextEdit;
+class QPushButton;
+
+class ProductImportDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ProductImportDialog(QWidget *parent = 0);
+
+    // Products imported since the dialog opened
+    int importedCount() const { return _importedCount; }
+
+public slots:
+    void browse();
+    void startImport();
+    void saveReport();
+    void reject();
+
+private slots:
+    void _onProgress(int done, int total);
+    void _onFinished();
+
+private:
+    QLineEdit* _pathEdit;
+    QProgressBar* _progressBar;
+    QPlainTextEdit* _reportEdit;
+    QPushButton* _browseButton;
+    QPushButton* _importButton;
+    QPushButton* _saveReportButton;
+    QPushButton* _closeButton;
+
+    // The import thread keeps its pooled connection until the dialog goes away
+    QThreadPool _pool;
+    QFutureWatcher<ProductImporter::Result> _watcher;
+    ProductImporter::Result _result;
+    int _importedCount;
+};
+
+#endif // PRODUCTIMPORTDIALOG_H
@@ -0,0 +1,549 @@
+#include "productimporter.h"
+#include "connectionpool.h"
+#include "product.h"
+#include "sql.h"
+#include "trace.h"
+
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int RowsPerStatement = 500;
+const int MaxUomCount = 5;
+const int MaxTierCount = 5;
+const int MaxNameLength = 100;
+// Smaller chunks are not worth a thread
+const qint64 MinChunkSize = 64 * 1024;
+
+QStringList splitFields(const char* begin, const char* end, char delimiter)
+{
+    QStringList fields;
+    QByteArray field;
+    bool quoted = false;
+
+    for (const char* p = begin; p < end; ++p) {
+        char c = *p;
+        if (quoted) {
+            if (c != '"')
+                field += c;
+            else if (p + 1 < end && p[1] == '"')
+                field += *++p;
+            else
+                quoted = false;
+        }
+        else if (c == '"') {
+            quoted = true;
+        }
+        else if (c == delimiter) {
+            fields << QString::fromUtf8(field).trimmed();
+            field.clear();
+        }
+        else {
+            field += c;
+        }
+    }
+    fields << QString::fromUtf8(field).trimmed();
+
+    return fields;
+}
+
+// Whole numbers, dots only as thousands separators between groups of three
+// digits, so "1.500" is 1500 but "1.5" or "2.50" are refused instead of misread
+bool parseNumber(QString text, quint64* value)
+{
+    text = text.trimmed();
+    if (text.contains('.')) {
+        QStringList groups = text.split('.');
+        if (groups.first().isEmpty() || groups.first().size() > 3)
+            return false;
+        for (int i = 1; i < groups.size(); i++) {
+            if (groups.at(i).size() != 3)
+                return false;
+        }
+        text = groups.join(QString());
+    }
+
+    for (const QChar& c: text) {
+        if (!c.isDigit())
+            return false;
+    }
+
+    bool ok = false;
+    *value = text.toULongLong(&ok);
+    return ok;
+}
+
+// Same forms as the editor's quantity column: "n", "a - b" and ">= n"
+bool parseQuantity(const QString& text, quint64* min, quint64* max)
+{
+    if (text.startsWith(">=")) {
+        *max = 0;
+        return parseNumber(text.mid(2), min) && *min > 0;
+    }
+
+    if (text.contains('-')) {
+        QStringList parts = text.split('-');
+        return parts.size() == 2
+            && parseNumber(parts.first(), min) && parseNumber(parts.last(), max)
+            && *min > 0 && *min < *max;
+    }
+
+    if (!parseNumber(text, min) || *min == 0)
+        return false;
+    *max = *min;
+    return true;
+}
+
+// Same forms as the editor's price columns: "n" and "a - b", empty for no price
+bool parsePrice(const QString& text, quint64* min, quint64* max)
+{
+    if (text.isEmpty()) {
+        *min = *max = 0;
+        return true;
+    }
+
+    if (text.contains('-')) {
+        QStringList parts = text.split('-');
+        return parts.size() == 2
+            && parseNumber(parts.first(), min) && parseNumber(parts.last(), max)
+            && *min < *max;
+    }
+
+    if (!parseNumber(text, min))
+        return false;
+    *max = *min;
+    return true;
+}
+
+bool execValues(QSqlQuery& q, const QString& prefix, const QStringList& values)
+{
+    for (int first = 0; first < values.size(); first += RowsPerStatement) {
+        if (!Sql::exec(q, prefix + values.mid(first, RowsPerStatement).join(','))) {
+            qDebug() << __FILE__ << __LINE__ << q.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+ProductImporter::Result ProductImporter::import(const QString& path, const Options& options,
+                                                const ProgressCallback& progress)
+{
+    SIMS_TRACE_SCOPE("ProductImporter::import");
+
+    Result result;
+
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        result.failure = QString("File %1 tidak dapat dibuka.").arg(path);
+        return result;
+    }
+
+    qint64 size = file.size();
+    if (size == 0)
+        return result;
+
+    uchar* mapped = file.map(0, size);
+    if (!mapped) {
+        result.failure = QString("File %1 tidak dapat dibaca.").arg(path);
+        return result;
+    }
+    const char* begin = reinterpret_cast<const char*>(mapped);
+    const char* end = begin + size;
+
+    if (size >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+        begin += 3;
+
+    // Tabs win over semicolons over commas, whichever the first line has
+    const char* firstLineEnd = std::find(begin, end, '\n');
+    char delimiter = ',';
+    if (std::count(begin, firstLineEnd, '\t'))
+        delimiter = '\t';
+    else if (std::count(begin, firstLineEnd, ';'))
+        delimiter = ';';
+
+    // Chunks end on line breaks, so no line is split between two threads
+    int threads = qMax(1, options.threads);
+    int chunkCount = int(qBound<qint64>(1, (end - begin) / MinChunkSize, threads * 4));
+    QVector<const char*> bounds;
+    bounds << begin;
+    for (int i = 1; i < chunkCount; i++) {
+        const char* p = std::find(begin + (end - begin) * i / chunkCount, end, '\n');
+        if (p != end)
+            ++p;
+        if (p > bounds.last() && p < end)
+            bounds << p;
+    }
+    bounds << end;
+
+    QVector<Row> rows;
+    {
+        SIMS_TRACE_SCOPE("ProductImporter::parse");
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+
+        QList<QFuture<Chunk> > futures;
+        for (int i = 0; i + 1 < bounds.size(); i++)
+            futures << QtConcurrent::run(&pool, &ProductImporter::parseChunk, bounds.at(i), bounds.at(i + 1), delimiter, i == 0);
+
+        // Chunks count their lines from one, the ones before them move them into place
+        int lineOffset = 0;
+        for (QFuture<Chunk>& future: futures) {
+            Chunk chunk = future.result();
+            for (Row& row: chunk.rows) {
+                row.line += lineOffset;
+                rows << row;
+            }
+            for (Error& error: chunk.errors) {
+                error.line += lineOffset;
+                result.errors << error;
+            }
+            result.rows += chunk.rows.size() + chunk.errors.size();
+            lineOffset += chunk.lineCount;
+        }
+    }
+
+    file.unmap(mapped);
+    file.close();
+
+    ConnectionPool::Lease lease;
+    QSqlDatabase db = lease.database();
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+
+    // Names are unique in any letter case, like the unique key on products.name
+    QSet<QString> existingNames;
+    if (!Sql::exec(q, "select name from products")) {
+        result.failure = q.lastError().text();
+        return result;
+    }
+    while (q.next())
+        existingNames.insert(q.value(0).toString().toLower());
+    q.finish();
+
+    QVector<Row> validRows;
+    validRows.reserve(rows.size());
+    QHash<QString, int> lineByName;
+    for (const Row& row: rows) {
+        QString key = row.name.toLower();
+        if (existingNames.contains(key)) {
+            result.errors << Error{ row.line, QString("Nama produk %1 sudah digunakan.").arg(row.name) };
+        }
+        else if (lineByName.contains(key)) {
+            result.errors << Error{ row.line, QString("Nama produk %1 sudah ada di baris %2.").arg(row.name, QString::number(lineByName.value(key))) };
+        }
+        else {
+            lineByName.insert(key, row.line);
+            validRows << row;
+        }
+    }
+
+    std::sort(result.errors.begin(), result.errors.end(), [](const Error& a, const Error& b) {
+        return a.line < b.line;
+    });
+
+    int batchSize = qMax(1, options.batchSize);
+    for (int first = 0; first < validRows.size(); first += batchSize) {
+        int count = qMin(batchSize, validRows.size() - first);
+        QString error;
+        if (!writeBatch(db, validRows, first, count, &error)) {
+            result.failure = QString("Gagal menyimpan baris %1 - %2: %3")
+                    .arg(validRows.at(first).line).arg(validRows.at(first + count - 1).line).arg(error);
+            break;
+        }
+
+        result.imported += count;
+        if (progress)
+            progress(result.imported, validRows.size());
+    }
+
+    return result;
+}
+
+QString ProductImporter::report(const Result& result)
+{
+    QStringList lines;
+    lines << QString("%1 dari %2 produk diimpor.").arg(result.imported).arg(result.rows);
+    if (!result.failure.isEmpty())
+        lines << result.failure;
+    for (const Error& error: result.errors)
+        lines << QString("Baris %1: %2").arg(error.line).arg(error.message);
+    return lines.join('\n');
+}
+
+ProductImporter::Chunk ProductImporter::parseChunk(const char* begin, const char* end, char delimiter, bool skipHeader)
+{
+    SIMS_TRACE_SCOPE("ProductImporter::parseChunk");
+
+    Chunk chunk;
+    chunk.lineCount = 0;
+
+    const char* lineBegin = begin;
+    while (lineBegin < end) {
+        const char* lineEnd = std::find(lineBegin, end, '\n');
+        const char* next = lineEnd == end ? end : lineEnd + 1;
+        if (lineEnd > lineBegin && lineEnd[-1] == '\r')
+            --lineEnd;
+
+        int line = ++chunk.lineCount;
+        QStringList fields = splitFields(lineBegin, lineEnd, delimiter);
+        lineBegin = next;
+
+        if (fields.size() == 1 && fields.first().isEmpty())
+            continue;
+
+        if (skipHeader && line == 1) {
+            QString first = fields.first().toLower();
+            if (first == "nama" || first == "name")
+                continue;
+        }
+
+        Row row;
+        QString error;
+        if (parseRow(fields, &row, &error)) {
+            row.line = line;
+            chunk.rows << row;
+        }
+        else {
+            chunk.errors << Error{ line, error };
+        }
+    }
+
+    return chunk;
+}
+
+bool ProductImporter::parseRow(const QStringList& fields, Row* row, QString* error)
+{
+    if (fields.size() < 4) {
+        *error = "Kolom nama, jenis, status dan satuan harus ada.";
+        return false;
+    }
+
+    row->name = fields.at(0);
+    if (row->name.isEmpty()) {
+        *error = "Nama produk harus diisi.";
+        return false;
+    }
+    if (row->name.size() > MaxNameLength) {
+        *error = QString("Nama produk lebih dari %1 huruf.").arg(MaxNameLength);
+        return false;
+    }
+
+    QString type = fields.at(1).toLower();
+    if (type.isEmpty() || type == "0" || type == Product::typeString(Product::Stocked).toLower())
+        row->type = Product::Stocked;
+    else if (type == "1" || type == Product::typeString(Product::NonStocked).toLower())
+        row->type = Product::NonStocked;
+    else if (type == "2" || type == Product::typeString(Product::Service).toLower())
+        row->type = Product::Service;
+    else {
+        *error = QString("Jenis %1 tidak dikenal.").arg(fields.at(1));
+        return false;
+    }
+
+    QString status = fields.at(2).toLower();
+    if (status.isEmpty() || status == "1" || status == "aktif")
+        row->active = true;
+    else if (status == "0" || status == "nonaktif")
+        row->active = false;
+    else {
+        *error = QString("Status %1 tidak dikenal.").arg(fields.at(2));
+        return false;
+    }
+
+    row->baseUom = fields.at(3);
+    if (row->baseUom.isEmpty()) {
+        *error = "Nama satuan dasar harus diisi.";
+        return false;
+    }
+
+    row->manualCost = 0;
+    if (fields.size() > 4 && !fields.at(4).isEmpty() && !parseNumber(fields.at(4), &row->manualCost)) {
+        *error = QString("Harga beli %1 tidak valid.").arg(fields.at(4));
+        return false;
+    }
+
+    // The unit rules of UomModel::setData()
+    QSet<QString> uomNames;
+    uomNames.insert(row->baseUom.toLower());
+    QStringList uoms = fields.size() > 5 ? fields.at(5).split('|', QString::SkipEmptyParts) : QStringList();
+    if (uoms.size() > MaxUomCount) {
+        *error = QString("Satuan lain paling banyak %1.").arg(MaxUomCount);
+        return false;
+    }
+    for (const QString& uom: uoms) {
+        int separator = uom.lastIndexOf('=');
+        QString name = uom.left(separator).trimmed();
+        quint64 quantity = 0;
+        if (separator == -1 || name.isEmpty() || !parseNumber(uom.mid(separator + 1), &quantity) || !quantity) {
+            *error = QString("Satuan %1 tidak valid, tulis sebagai nama=isi.").arg(uom.trimmed());
+            return false;
+        }
+        if (uomNames.contains(name.toLower())) {
+            *error = QString("Satuan %1 ditulis lebih dari sekali.").arg(name);
+            return false;
+        }
+        uomNames.insert(name.toLower());
+        row->uoms << qMakePair(name, quantity);
+    }
+
+    // The tier rules of PriceModel::setData(), then the overlap and gap checks of the editor's save
+    QStringList tiers = fields.size() > 6 ? fields.at(6).split('|', QString::SkipEmptyParts) : QStringList();
+    if (tiers.size() > MaxTierCount) {
+        *error = QString("Tingkat harga paling banyak %1.").arg(MaxTierCount);
+        return false;
+    }
+    for (const QString& text: tiers) {
+        QString tierText = text.trimmed();
+        int separator = tierText.indexOf('=', tierText.startsWith(">=") ? 2 : 0);
+        PriceTable::Tier tier;
+        if (separator == -1 || !parseQuantity(tierText.left(separator).trimmed(), &tier.quantityMin, &tier.quantityMax)) {
+            *error = QString("Kwantitas harga %1 tidak valid.").arg(tierText);
+            return false;
+        }
+
+        QStringList prices = tierText.mid(separator + 1).split('/');
+        if (prices.size() > PriceTable::LevelCount) {
+            *error = QString("Harga %1 lebih dari %2 level.").arg(tierText, QString::number(PriceTable::LevelCount));
+            return false;
+        }
+        for (int level = 0; level < prices.size(); level++) {
+            if (!parsePrice(prices.at(level).trimmed(), &tier.priceMin[level], &tier.priceMax[level])) {
+                *error = QString("Harga %1 tidak valid.").arg(prices.at(level).trimmed());
+                return false;
+            }
+        }
+        row->tiers << tier;
+    }
+
+    QStringList problems = PriceTable(row->tiers).problems();
+    if (!problems.isEmpty()) {
+        *error = problems.join(' ');
+        return false;
+    }
+
+    return true;
+}
+
+bool ProductImporter::writeBatch(QSqlDatabase& db, const QVector<Row>& rows, int first, int count, QString* error)
+{
+    SIMS_TRACE_SCOPE("ProductImporter::writeBatch");
+
+    QSqlDriver* driver = db.driver();
+    QSqlField textField("text", QVariant::String);
+    auto quoted = [driver, &textField](const QString& text) {
+        textField.setValue(text);
+        return driver->formatValue(textField);
+    };
+
+    QStringList products;
+    QStringList names;
+    products.reserve(count);
+    names.reserve(count);
+    for (int i = first; i < first + count; i++) {
+        const Row& row = rows.at(i);
+        QString name = quoted(row.name);
+        names << name;
+        // One arg() call, so a % in a name is never taken for a placeholder
+        products << QString("(%1,%2,%3,%4,%5,%6,%6)")
+                    .arg(name,
+                         QString::number(row.type),
+                         QString::number(row.active ? 1 : 0),
+                         quoted(row.baseUom),
+                         QString::number(int(Product::Manual)),
+                         QString::number(row.manualCost));
+    }
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+
+    if (!db.transaction()) {
+        *error = db.lastError().text();
+        return false;
+    }
+
+    if (!execValues(q, "insert into products(name, type, active, baseUom, costingMethod, cost, manualCost) values ", products)) {
+        *error = q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    // Auto increment ids are not always consecutive, so they are read back by name
+    QHash<QString, quint16> idByName;
+    idByName.reserve(count);
+    for (int i = 0; i < names.size(); i += RowsPerStatement) {
+        if (!Sql::exec(q, QString("select id, name from products where name in (%1)")
+                       .arg(names.mid(i, RowsPerStatement).join(',')))) {
+            *error = q.lastError().text();
+            db.rollback();
+            return false;
+        }
+        while (q.next()) {
+            // Product ids are 16 bit everywhere else, a larger one would wrap onto an existing product
+            uint id = q.value(0).toUInt();
+            if (id > 0xFFFF) {
+                *error = QString("Id produk %1 melebihi batas %2, produk tidak dapat ditambahkan lagi.")
+                        .arg(id).arg(0xFFFF);
+                db.rollback();
+                return false;
+            }
+            idByName.insert(q.value(1).toString().toLower(), quint16(id));
+        }
+    }
+
+    QStringList uoms;
+    QStringList prices;
+    for (int i = first; i < first + count; i++) {
+        const Row& row = rows.at(i);
+        quint16 id = idByName.value(row.name.toLower());
+        if (!id) {
+            *error = QString("Produk %1 tidak ditemukan setelah disimpan.").arg(row.name);
+            db.rollback();
+            return false;
+        }
+
+        for (const QPair<QString, quint64>& uom: row.uoms)
+            uoms << QString("(%1,%2,%3)").arg(QString::number(id), quoted(uom.first), QString::number(uom.second));
+
+        for (const PriceTable::Tier& tier: row.tiers) {
+            prices << QString("(%1,%2,%3,%4,%5,%6,%7,%8,%9)")
+                      .arg(id).arg(tier.quantityMin).arg(tier.quantityMax)
+                      .arg(tier.priceMin[0]).arg(tier.priceMax[0])
+                      .arg(tier.priceMin[1]).arg(tier.priceMax[1])
+                      .arg(tier.priceMin[2]).arg(tier.priceMax[2]);
+        }
+    }
+
+    if (!execValues(q, "insert into product_uoms(productId, name, quantity) values ", uoms)
+            || !execValues(q, "insert into product_prices(productId, quantityMin, quantityMax,"
+                              " price1Min, price1Max, price2Min, price2Max, price3Min, price3Max) values ", prices)) {
+        *error = q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        *error = db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef PRODUCTIMPORTER_H
+#define PRODUCTIMPORTER_H
+
+#include "pricetable.h"
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <QThread>
+#include <functional>
+
+class QSqlDatabase;
+
+// Imports products with their units and price tiers from a CSV or TSV file.
+// One line per product:
+//
+//     nama, jenis, status, satuan, harga beli, satuan lain, harga
+//
+// where satuan lain is "Lusin=12|Dus=48" and harga lists tiers as
+// "1-11=10000/9500/9000-9400|>=12=9000/8500/8000", quantity first, then the
+// three price levels. Fields may be quoted but may not span lines.
+// The file is mapped and parsed in chunks on several threads, rows are
+// checked with the editor's rules and the valid ones written in batches.
+class ProductImporter
+{
+public:
+    struct Options
+    {
+        int threads;
+        // Products per transaction
+        int batchSize;
+
+        Options() : threads(QThread::idealThreadCount()), batchSize(1000) {}
+    };
+
+    struct Error
+    {
+        int line;
+        QString message;
+    };
+
+    struct Result
+    {
+        int rows;
+        int imported;
+        QList<Error> errors;
+        // Set when the file could not be read or a batch could not be written
+        QString failure;
+
+        Result() : rows(0), imported(0) {}
+    };
+
+    // Called from the importing thread as batches commit
+    typedef std::function<void(int done, int total)> ProgressCallback;
+
+    // Connections come from the ConnectionPool, for the calling thread
+    static Result import(const QString& path, const Options& options = Options(),
+                         const ProgressCallback& progress = ProgressCallback());
+
+    // Errors one per line, for the user to save or copy
+    static QString report(const Result& result);
+
+private:
+    struct Row
+    {
+        int line;
+        QString name;
+        quint8 type;
+        bool active;
+        QString baseUom;
+        quint64 manualCost;
+        QVector<QPair<QString, quint64> > uoms;
+        QVector<PriceTable::Tier> tiers;
+    };
+
+    struct Chunk
+    {
+        QVector<Row> rows;
+        QList<Error> errors;
+        int lineCount;
+    };
+
+    static Chunk parseChunk(const char* begin, const char* end, char delimiter, bool skipHeader);
+    static bool parseRow(const QStringList& fields, Row* row, QString* error);
+    static bool writeBatch(QSqlDatabase& db, const QVector<Row>& rows, int first, int count, QString* error);
+};
+
+#endif // PRODUCTIMPORTER_H
@@ -0,0 +1,158 @@
+#include "productlistsnapshot.h"
+#include "productrowstore.h"
+#include "checksum.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QDebug>
+
+#include <cstring>
+
+namespace {
+
+const char Magic[8] = { 'S', 'I', 'M', 'S', 'P', 'L', 'S', '\0' };
+
+// Strings are padded so the arrays after them stay aligned
+int padded(int size)
+{
+    return (size + 3) & ~3;
+}
+
+}
+
+QString ProductListSnapshot::defaultPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(dir);
+    return dir + "/product-list.snapshot";
+}
+
+bool ProductListSnapshot::load(const QString& path, const QString& databaseKey, ProductRowStore* rows, QString* version)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    qint64 size = file.size();
+    if (size < qint64(sizeof(Header)))
+        return false;
+
+    const uchar* data = file.map(0, size);
+    if (!data)
+        return false;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.formatVersion != FormatVersion)
+        return false;
+
+    qint64 offset = sizeof(Header);
+    qint64 expected = offset + padded(header.keyLength) + padded(header.versionLength)
+            + qint64(header.count) * 6 + qint64(header.namesLength) * 2;
+    if (expected != size)
+        return false;
+
+    QString key = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), header.keyLength);
+    offset += padded(header.keyLength);
+    if (key != databaseKey)
+        return false;
+
+    *version = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), header.versionLength);
+    offset += padded(header.versionLength);
+
+    int count = int(header.count);
+    const quint16* ids = reinterpret_cast<const quint16*>(data + offset);
+    offset += count * 2;
+    const quint8* types = data + offset;
+    offset += count;
+    const quint8* flags = data + offset;
+    offset += count;
+    const quint16* nameLengths = reinterpret_cast<const quint16*>(data + offset);
+    offset += count * 2;
+    const QChar* names = reinterpret_cast<const QChar*>(data + offset);
+
+    rows->clear();
+    rows->_ids.resize(count);
+    rows->_types.resize(count);
+    rows->_flags.resize(count);
+    rows->_nameLengths.resize(count);
+    rows->_nameOffsets.resize(count);
+    std::memcpy(rows->_ids.data(), ids, count * 2);
+    std::memcpy(rows->_types.data(), types, count);
+    std::memcpy(rows->_flags.data(), flags, count);
+    std::memcpy(rows->_nameLengths.data(), nameLengths, count * 2);
+    rows->_names = QString(names, int(header.namesLength));
+
+    quint32 nameOffset = 0;
+    for (int i = 0; i < count; i++) {
+        rows->_nameOffsets[i] = nameOffset;
+        nameOffset += rows->_nameLengths.at(i);
+    }
+
+    if (nameOffset != header.namesLength) {
+        rows->clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool ProductListSnapshot::save(const QString& path, const QString& databaseKey, const ProductRowStore& rows, const QString& version)
+{
+    // Names are written back to back in row order, dropping the arena's unused slots
+    QString names;
+    names.reserve(rows._names.size() - rows._wasted);
+    for (int i = 0; i < rows.size(); i++)
+        names += rows.nameView(i);
+
+    QByteArray key = databaseKey.toUtf8();
+    QByteArray serverVersion = version.toUtf8();
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.formatVersion = FormatVersion;
+    header.count = quint32(rows.size());
+    header.namesLength = quint32(names.size());
+    header.keyLength = quint32(key.size());
+    header.versionLength = quint32(serverVersion.size());
+    header.reserved = 0;
+
+    key.append(padded(key.size()) - key.size(), '\0');
+    serverVersion.append(padded(serverVersion.size()) - serverVersion.size(), '\0');
+
+    // Written beside the old file and renamed over it, a crash never leaves half a snapshot
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        qDebug() << "Unable to write product list snapshot:" << qPrintable(file.errorString());
+        return false;
+    }
+
+    int count = rows.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(key);
+    file.write(serverVersion);
+    file.write(reinterpret_cast<const char*>(rows._ids.constData()), count * 2);
+    file.write(reinterpret_cast<const char*>(rows._types.constData()), count);
+    file.write(reinterpret_cast<const char*>(rows._flags.constData()), count);
+    file.write(reinterpret_cast<const char*>(rows._nameLengths.constData()), count * 2);
+    file.write(reinterpret_cast<const char*>(names.constData()), names.size() * 2);
+
+    return file.commit();
+}
+
+quint32 ProductListSnapshot::rowChecksum(const ProductRowStore& rows, int row)
+{
+    QByteArray text = rows.nameView(row).toUtf8();
+    text += char(31);
+    text += QByteArray::number(rows.type(row));
+    text += char(31);
+    text += rows.isActive(row) ? '1' : '0';
+    return Checksum::crc32(0, text.constData(), text.size());
+}
+
+const char* ProductListSnapshot::rowChecksumExpression()
+{
+    return "crc32(concat_ws(char(31), name, type, active))";
+}
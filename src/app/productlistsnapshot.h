@@ -0,0 +1,39 @@
+#ifndef PRODUCTLISTSNAPSHOT_H
+#define PRODUCTLISTSNAPSHOT_H
+
+#include <QString>
+
+class ProductRowStore;
+
+// On-disk copy of the full product list, so the list can be shown before
+// the server answers. The file holds the row store arrays as they are in
+// memory and is read through a memory map. It remembers which database it
+// came from and the server's table checksum at the time it was written.
+class ProductListSnapshot
+{
+public:
+    static QString defaultPath();
+
+    static bool load(const QString& path, const QString& databaseKey, ProductRowStore* rows, QString* version);
+    static bool save(const QString& path, const QString& databaseKey, const ProductRowStore& rows, const QString& version);
+
+    // Same value as the server side rowChecksumExpression() for the row, when names are stored as UTF-8
+    static quint32 rowChecksum(const ProductRowStore& rows, int row);
+    static const char* rowChecksumExpression();
+
+private:
+    struct Header
+    {
+        char magic[8];
+        quint32 formatVersion;
+        quint32 count;
+        quint32 namesLength;
+        quint32 keyLength;
+        quint32 versionLength;
+        quint32 reserved;
+    };
+
+    static const quint32 FormatVersion = 1;
+};
+
+#endif // PRODUCTLISTSNAPSHOT_H
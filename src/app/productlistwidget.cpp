@@ -1,66 +1,267 @@
 #include "productlistwidget.h"
+#include "productsearchindex.h"
+#include "productrowstore.h"
+#include "connectionpool.h"
+#include "productlistsnapshot.h"
+#include "sql.h"
+#include "trace.h"
 #include "product.h"
+#include "global.h"
 
 #include <QAbstractTableModel>
 #include <QSortFilterProxyModel>
+#include <QStyledItemDelegate>
+#include <QApplication>
+#include <QStyle>
 
 #include <QToolBar>
+#include <QToolButton>
+#include <QMenu>
 #include <QTableView>
 #include <QHeaderView>
 #include <QBoxLayout>
+#include <QLabel>
+#include <QComboBox>
+#include <QLineEdit>
+
+#include <QSettings>
+#include <QCache>
+#include <QSet>
+#include <QStringList>
 
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
 
+#include <QtConcurrentRun>
+#include <QFutureWatcher>
+#include <QThreadPool>
+
+#include <algorithm>
+
+static const int MaxSearchResults = 200;
+
 class ProductListWidget::Model : public QAbstractTableModel
 {
     Q_OBJECT
 
 public:
-    struct Item {
-        quint16 id;
-        quint8 type;
-        bool active;
-        QString code;
-        QString name;
-
-        QString statusString() const
+    ProductRowStore rows;
+    ProductSearchIndex searchIndex;
+
+    enum Column {
+        Code,
+        Name,
+        Type,
+        Active,
+        _COUNT
+    };
+
+    // Sort and filter state, applied by the database rather than in memory
+    struct Query
+    {
+        int sortColumn;
+        Qt::SortOrder sortOrder;
+        int type;
+        int active;
+
+        // Only the windowed mode sends the search text to the database, a full list is searched through searchIndex
+        QString search;
+
+        Query() : sortColumn(Column::Code), sortOrder(Qt::AscendingOrder), type(-1), active(-1) {}
+
+        // The rows a snapshot holds, in whatever order
+        bool isUnfiltered() const
         {
-            return active ? "Aktif" : "Nonaktif";
+            return type == -1 && active == -1 && search.isEmpty();
         }
 
-        QString typeString() const
+        bool operator==(const Query& other) const
         {
-            switch (type) {
-            case 0: return "Stok";
-            case 1: return "Non Stok";
-            case 2: return "Jasa";
-            case 255: return "Voucher ShiftNet";
+            return sortColumn == other.sortColumn && sortOrder == other.sortOrder
+                && type == other.type && active == other.active && search == other.search;
+        }
+
+        QString whereClause(bool withSearch = false) const
+        {
+            QString clause = "type <= 200";
+            if (type != -1)
+                clause += QString(" and type = %1").arg(type);
+            if (active != -1)
+                clause += QString(" and active = %1").arg(active ? 1 : 0);
+            if (withSearch && !search.isEmpty())
+                clause += " and (name like :search or id = :searchId)";
+            return clause;
+        }
+
+        void bindSearch(QSqlQuery& q, bool withSearch) const
+        {
+            if (!withSearch || search.isEmpty())
+                return;
+
+            quint32 code = 0;
+            int digits = 0;
+            q.bindValue(":search", "%" + search + "%");
+            q.bindValue(":searchId", ProductSearchIndex::parseCode(search, &code, &digits) ? int(code) : -1);
+        }
+
+        QString orderByClause() const
+        {
+            QString direction = sortOrder == Qt::AscendingOrder ? "asc" : "desc";
+            QString column;
+            switch (sortColumn) {
+            case Column::Name: column = "name"; break;
+            case Column::Type: column = "type"; break;
+            case Column::Active: column = "active"; break;
             }
 
-            return QString();
+            // id breaks ties, so pages fetched with an offset never overlap
+            if (column.isEmpty())
+                return QString("id %1").arg(direction);
+            return QString("%1 %2, id %2").arg(column, direction);
         }
     };
-    QList<Item> items;
 
-    enum Column {
-        Code,
-        Name,
-        Type,
-        Active,
-        _COUNT
-    };
+    // Large catalog (windowed) mode: only the row count is kept, rows are fetched page by page
+    static const int PageSize = 256;
+    static const int MaxCachedPages = 64;
 
     Model(QObject* parent)
         : QAbstractTableModel(parent)
-    {}
+        , _refreshPending(false)
+        , _snapshotTried(false)
+        , _windowed(false)
+        , _rowCount(0)
+        , _generation(0)
+        , _lastPage(0)
+    {
+        // A single long-lived loader thread, so its named connection stays open between refreshes
+        _loaderPool.setMaxThreadCount(1);
+        _loaderPool.setExpiryTimeout(-1);
+
+        _pages.setMaxCost(MaxCachedPages);
+
+        connect(&_watcher, SIGNAL(finished()), SLOT(_onFetchFinished()));
+    }
+
+    ~Model()
+    {
+        _loaderPool.clear();
+        _loaderPool.waitForDone();
+        QtConcurrent::run(&_loaderPool, &Model::closeConnection).waitForFinished();
+    }
+
+    bool isWindowed() const
+    {
+        return _windowed;
+    }
+
+    // Returns 0 for a windowed row whose page has not arrived yet
+    quint16 idAt(int row) const
+    {
+        if (!_windowed)
+            return rows.id(row);
+
+        Page* page = _pages.object(row / PageSize);
+        return page ? page->id(row % PageSize) : 0;
+    }
+
+    // Ids of windowed rows first to first + count - 1 straight from the database, for pages not cached.
+    // Blocks the calling thread, meant for one query over a whole selection.
+    bool fetchIds(int first, int count, QVector<quint16>* ids) const
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::fetchIds");
+
+        QSqlQuery q(ConnectionPool::instance()->database());
+        q.setForwardOnly(true);
+        q.prepare(QString("select id from products where %1 order by %2 limit %3 offset %4")
+                  .arg(_query.whereClause(true), _query.orderByClause())
+                  .arg(count).arg(first));
+        _query.bindSearch(q, true);
+        if (!Sql::exec(q)) {
+            qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+            return false;
+        }
+
+        while (q.next())
+            *ids << q.value(0).value<quint16>();
+        return true;
+    }
+
+    // Finds the store holding a row without going through data(), false while its windowed page is still loading
+    bool locate(int row, const ProductRowStore** store, int* storeRow) const
+    {
+        if (!_windowed) {
+            *store = &rows;
+            *storeRow = row;
+            return true;
+        }
+
+        *store = windowedPage(row);
+        *storeRow = row % PageSize;
+        return *store != 0;
+    }
+
+    void setFilter(int type, int active)
+    {
+        Query query = _query;
+        query.type = type;
+        query.active = active;
+        setQuery(query);
+    }
+
+    void setSearch(const QString& text)
+    {
+        if (text == _query.search)
+            return;
+
+        _query.search = text;
+        if (_windowed)
+            refresh();
+    }
+
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder)
+    {
+        Query query = _query;
+        query.sortColumn = column;
+        query.sortOrder = order;
+        if (query == _query)
+            return;
+
+        // Only the windowed list needs the server to sort, a full list is already here
+        if (_windowed || _watcher.isRunning()) {
+            setQuery(query);
+            return;
+        }
+
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::sort");
+
+        _query = query;
+        emit layoutAboutToBeChanged();
+
+        QModelIndexList persistent = persistentIndexList();
+        QVector<quint16> persistentIds;
+        persistentIds.reserve(persistent.size());
+        for (const QModelIndex& index: persistent)
+            persistentIds << rows.id(index.row());
+
+        sortRows(&rows, column, order);
+        rebuildRowIndex();
+
+        QModelIndexList moved;
+        moved.reserve(persistent.size());
+        for (int i = 0; i < persistent.size(); i++)
+            moved << index(_rowById.value(persistentIds.at(i)), persistent.at(i).column());
+        changePersistentIndexList(persistent, moved);
+
+        emit layoutChanged();
+    }
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const
     {
         Q_UNUSED(parent)
-        return items.size();
+        return _windowed ? _rowCount : rows.size();
     }
 
     int columnCount(const QModelIndex &parent = QModelIndex()) const
@@ -71,15 +272,22 @@ public:
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const
     {
-        Item item = items.at(index.row());
-        if (role == Qt::DisplayRole) {
-            switch (index.column()) {
-            case Column::Code: return item.code;
-            case Column::Name: return item.name;
-            case Column::Type: return item.typeString();
-            case Column::Active: return item.statusString();
-            }
+        if (role != Qt::DisplayRole)
+            return QVariant();
+
+        // Blank until a windowed page arrives
+        const ProductRowStore* store = 0;
+        int row = 0;
+        if (!locate(index.row(), &store, &row))
+            return QVariant();
+
+        switch (index.column()) {
+        case Column::Code: return store->code(row);
+        case Column::Name: return store->name(row);
+        case Column::Type: return ProductRowStore::typeString(store->type(row));
+        case Column::Active: return ProductRowStore::statusString(store->isActive(row));
         }
+
         return QVariant();
     }
 
@@ -99,31 +307,603 @@ public:
         return QVariant();
     }
 
+signals:
+    void loadingChanged(bool loading);
+
 public slots:
-    bool refresh()
+    void refresh()
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::refresh");
+
+        // Overlapping requests are merged into a single follow-up fetch
+        if (_watcher.isRunning()) {
+            _refreshPending = true;
+            return;
+        }
+
+        if (!_snapshotTried) {
+            _snapshotTried = true;
+            if (_query == Query())
+                loadSnapshot();
+        }
+
+        startFetch();
+        emit loadingChanged(true);
+    }
+
+    void upsert(quint16 id)
+    {
+        _snapshotVersion.clear();
+
+        // Queued on the same loader thread, so it always lands after any refresh requested before it
+        QFutureWatcher<FetchResult>* watcher = new QFutureWatcher<FetchResult>(this);
+        connect(watcher, SIGNAL(finished()), SLOT(_onFetchOneFinished()));
+        watcher->setProperty("productId", id);
+        watcher->setFuture(QtConcurrent::run(&_loaderPool, &Model::fetchOne, _query, id, _windowed));
+    }
+
+    void remove(quint16 id)
+    {
+        _snapshotVersion.clear();
+
+        int row = rowOf(id);
+        if (row == -1) {
+            // A windowed row outside the cached pages, its position is only known to the server
+            if (_windowed)
+                refresh();
+            return;
+        }
+
+        beginRemoveRows(QModelIndex(), row, row);
+        if (!_windowed) {
+            _rowById.remove(id);
+            searchIndex.remove(id);
+            rows.removeAt(row);
+            for (int i = row; i < rows.size(); i++)
+                _rowById.insert(rows.id(i), i);
+        }
+        else {
+            _rowCount--;
+            dropPagesFrom(row / PageSize);
+        }
+        endRemoveRows();
+    }
+
+private slots:
+    void _onFetchFinished()
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::applyFetch");
+
+        // The result in flight predates the latest request, fetch again instead of showing stale rows
+        if (_refreshPending) {
+            startFetch();
+            return;
+        }
+
+        FetchResult result = _watcher.result();
+        emit loadingChanged(false);
+
+        if (!result.ok)
+            return;
+
+        beginResetModel();
+        _generation++;
+        _windowed = result.windowed;
+        _rowCount = result.count;
+        rows = result.rows;
+        searchIndex = result.searchIndex;
+        _snapshotVersion = result.version;
+        _pages.clear();
+        _pendingPages.clear();
+        _lastPage = 0;
+        rebuildRowIndex();
+        endResetModel();
+    }
+
+    void _onFetchOneFinished()
+    {
+        QFutureWatcher<FetchResult>* watcher = static_cast<QFutureWatcher<FetchResult>*>(sender());
+        quint16 id = watcher->property("productId").value<quint16>();
+        FetchResult result = watcher->result();
+        watcher->deleteLater();
+
+        if (!result.ok)
+            return;
+
+        // Not found means the product was deleted or no longer matches the filter
+        if (result.rows.isEmpty()) {
+            remove(id);
+            return;
+        }
+
+        quint8 type = result.rows.type(0);
+        bool active = result.rows.isActive(0);
+        QString name = result.rows.name(0);
+        int row = rowOf(id);
+        if (row == -1) {
+            // Only the server knows where a new row sorts into a windowed list
+            if (_windowed) {
+                refresh();
+                return;
+            }
+
+            row = rows.size();
+            beginInsertRows(QModelIndex(), row, row);
+            rows.append(id, type, active, name);
+            _rowById.insert(id, row);
+            searchIndex.insert(id, name);
+            endInsertRows();
+            return;
+        }
+
+        if (!_windowed) {
+            rows.set(row, type, active, name);
+            searchIndex.insert(id, name);
+        }
+        else {
+            _pages.object(row / PageSize)->set(row % PageSize, type, active, name);
+        }
+
+        emit dataChanged(index(row, 0), index(row, Column::_COUNT - 1));
+    }
+
+    void _onFetchPageFinished()
+    {
+        QFutureWatcher<FetchResult>* watcher = static_cast<QFutureWatcher<FetchResult>*>(sender());
+        int pageIndex = watcher->property("page").toInt();
+        int generation = watcher->property("generation").toInt();
+        FetchResult result = watcher->result();
+        watcher->deleteLater();
+
+        // Rows were reset or shifted while the page was in flight
+        if (generation != _generation || !_pendingPages.remove(pageIndex))
+            return;
+
+        if (!result.ok || result.rows.isEmpty())
+            return;
+
+        int first = pageIndex * PageSize;
+        int last = qMin(first + result.rows.size(), _rowCount) - 1;
+        if (last < first)
+            return;
+
+        Page* page = new Page(result.rows);
+        while (page->size() > last - first + 1)
+            page->removeAt(page->size() - 1);
+
+        _pages.insert(pageIndex, page);
+        emit dataChanged(index(first, 0), index(last, Column::_COUNT - 1));
+    }
+
+private:
+    typedef ProductRowStore Page;
+
+    // Where the full list is kept between sessions, and what the list held when the fetch started
+    struct Snapshot
+    {
+        QString path;
+        QString databaseKey;
+        QString version;
+        ProductRowStore rows;
+    };
+
+    struct FetchResult
+    {
+        bool ok;
+        bool windowed;
+        int count;
+        ProductRowStore rows;
+        ProductSearchIndex searchIndex;
+        QString version;
+
+        FetchResult() : ok(false), windowed(false), count(0) {}
+    };
+
+    static int windowedThreshold()
+    {
+        QSettings settings(SIMS_DEFAULT_SETTINGS_PATH, QSettings::IniFormat);
+        return settings.value("ProductList/windowedThreshold", 50000).toInt();
+    }
+
+    void setQuery(const Query& query)
     {
-        QSqlQuery q("select id, name, type, active from products where type <= 200", QSqlDatabase::database());
-        if (!q.exec()) {
+        if (query == _query)
+            return;
+
+        _query = query;
+        refresh();
+    }
+
+    static QString snapshotPath()
+    {
+        QSettings settings(SIMS_DEFAULT_SETTINGS_PATH, QSettings::IniFormat);
+        if (!settings.value("ProductList/snapshot", true).toBool())
+            return QString();
+        return ProductListSnapshot::defaultPath();
+    }
+
+    static QString databaseKey()
+    {
+        ConnectionPool::Settings settings = ConnectionPool::instance()->settings();
+        return QString("%1://%2:%3/%4").arg(settings.driverName, settings.hostName)
+                .arg(settings.port).arg(settings.databaseName);
+    }
+
+    // Shows the list saved by the previous session while the first fetch brings it up to date
+    void loadSnapshot()
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::loadSnapshot");
+
+        QString path = snapshotPath();
+        if (path.isEmpty())
+            return;
+
+        ProductRowStore snapshotRows;
+        QString version;
+        if (!ProductListSnapshot::load(path, databaseKey(), &snapshotRows, &version))
+            return;
+
+        beginResetModel();
+        _windowed = false;
+        _rowCount = snapshotRows.size();
+        rows = snapshotRows;
+        _snapshotVersion = version;
+        rebuildRowIndex();
+        endResetModel();
+    }
+
+    void startFetch()
+    {
+        _refreshPending = false;
+
+        // Only the unfiltered list is kept as a snapshot, and only a full list can be reconciled against it
+        Snapshot snapshot;
+        if (_query.isUnfiltered()) {
+            snapshot.path = snapshotPath();
+            snapshot.databaseKey = databaseKey();
+            if (!_windowed) {
+                snapshot.version = _snapshotVersion;
+                snapshot.rows = rows;
+            }
+        }
+
+        _watcher.setFuture(QtConcurrent::run(&_loaderPool, &Model::fetch, windowedThreshold(), _query, snapshot));
+    }
+
+    void rebuildRowIndex()
+    {
+        _rowById.clear();
+        if (_windowed)
+            return;
+
+        _rowById.reserve(rows.size());
+        for (int i = 0; i < rows.size(); i++)
+            _rowById.insert(rows.id(i), i);
+    }
+
+    int rowOf(quint16 id) const
+    {
+        if (!_windowed)
+            return _rowById.value(id, -1);
+
+        for (int pageIndex: _pages.keys()) {
+            const Page* page = _pages.object(pageIndex);
+            for (int i = 0; i < page->size(); i++) {
+                if (page->id(i) == id)
+                    return pageIndex * PageSize + i;
+            }
+        }
+
+        return -1;
+    }
+
+    const Page* windowedPage(int row) const
+    {
+        Model* self = const_cast<Model*>(this);
+        int pageIndex = row / PageSize;
+
+        // QCache::object() also marks the page as most recently used
+        Page* page = _pages.object(pageIndex);
+        if (!page)
+            self->requestPage(pageIndex);
+
+        // Read ahead one page in the direction the view is scrolling
+        if (pageIndex != _lastPage) {
+            int direction = pageIndex > _lastPage ? 1 : -1;
+            self->_lastPage = pageIndex;
+            self->requestPage(pageIndex + direction);
+        }
+
+        return page;
+    }
+
+    void requestPage(int pageIndex)
+    {
+        if (pageIndex < 0 || pageIndex * PageSize >= _rowCount)
+            return;
+
+        if (_pages.contains(pageIndex) || _pendingPages.contains(pageIndex))
+            return;
+
+        _pendingPages.insert(pageIndex);
+
+        QFutureWatcher<FetchResult>* watcher = new QFutureWatcher<FetchResult>(this);
+        connect(watcher, SIGNAL(finished()), SLOT(_onFetchPageFinished()));
+        watcher->setProperty("page", pageIndex);
+        watcher->setProperty("generation", _generation);
+        watcher->setFuture(QtConcurrent::run(&_loaderPool, &Model::fetchPage, _query, pageIndex));
+    }
+
+    void dropPagesFrom(int pageIndex)
+    {
+        for (int key: _pages.keys()) {
+            if (key >= pageIndex)
+                _pages.remove(key);
+        }
+
+        // Pages in flight would land on shifted rows
+        _generation++;
+        _pendingPages.clear();
+    }
+
+    // The functions below run on the loader thread, which holds its own pooled connection
+    // Same order as Query::orderByClause(), names compared without case like the server's collation
+    static void sortRows(ProductRowStore* rows, int column, Qt::SortOrder order)
+    {
+        QVector<int> sorted(rows->size());
+        for (int i = 0; i < sorted.size(); i++)
+            sorted[i] = i;
+
+        const ProductRowStore& store = *rows;
+        std::sort(sorted.begin(), sorted.end(), [&store, column, order](int a, int b) {
+            int result = 0;
+            switch (column) {
+            case Column::Name: result = QString::compare(store.nameView(a), store.nameView(b), Qt::CaseInsensitive); break;
+            case Column::Type: result = int(store.type(a)) - int(store.type(b)); break;
+            case Column::Active: result = int(store.isActive(a)) - int(store.isActive(b)); break;
+            }
+            if (!result)
+                result = int(store.id(a)) - int(store.id(b));
+            return order == Qt::AscendingOrder ? result < 0 : result > 0;
+        });
+
+        ProductRowStore result;
+        result.reserve(sorted.size());
+        for (int row: sorted)
+            result.append(store.id(row), store.type(row), store.isActive(row), store.nameView(row));
+        *rows = result;
+    }
+
+    static void readRow(const QSqlQuery& q, ProductRowStore* store)
+    {
+        store->append(q.value(0).value<quint16>(), q.value(2).value<quint8>(), q.value(3).toBool(), q.value(1).toString());
+    }
+
+    static FetchResult fetch(int windowedThreshold, const Query& query, const Snapshot& snapshot)
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::fetch");
+
+        FetchResult result;
+
+        QSqlDatabase db = ConnectionPool::instance()->database();
+        if (!db.isOpen())
+            return result;
+
+        QSqlQuery q(db);
+        q.setForwardOnly(true);
+
+        // Taken before the rows are read, so a change made in between shows up as a new version next time.
+        // Only MySQL has a table checksum, other servers always get a full fetch.
+        if (!snapshot.path.isEmpty() && db.driverName() == "QMYSQL") {
+            if (Sql::exec(q, "checksum table products") && q.next())
+                result.version = q.value(1).toString();
+            else
+                qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+        }
+
+        if (!Sql::exec(q, QString("select count(0) from products where %1").arg(query.whereClause())) || !q.next()) {
+            qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+            return result;
+        }
+
+        result.count = q.value(0).toInt();
+        result.windowed = windowedThreshold > 0 && result.count >= windowedThreshold;
+
+        bool unchanged = false;
+        if (result.windowed) {
+            // Searching narrows the windowed rows but never decides the mode, which is based on the count above
+            if (!query.search.isEmpty()) {
+                q.prepare(QString("select count(0) from products where %1").arg(query.whereClause(true)));
+                query.bindSearch(q, true);
+                if (!Sql::exec(q) || !q.next()) {
+                    qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+                    return result;
+                }
+                result.count = q.value(0).toInt();
+            }
+
+            // Windowed rows are fetched on demand by fetchPage()
+        }
+        else if (!result.version.isEmpty() && result.version == snapshot.version) {
+            // Nothing changed on the server since the list was read
+            result.rows = snapshot.rows;
+            sortRows(&result.rows, query.sortColumn, query.sortOrder);
+            unchanged = true;
+        }
+        else if (!result.version.isEmpty() && !snapshot.rows.isEmpty()) {
+            if (!reconcile(q, snapshot.rows, &result.rows))
+                return result;
+            sortRows(&result.rows, query.sortColumn, query.sortOrder);
+        }
+        else {
+            if (!Sql::exec(q, QString("select id, name, type, active from products where %1 order by %2")
+                        .arg(query.whereClause(), query.orderByClause()))) {
+                qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+                return result;
+            }
+
+            result.rows.reserve(result.count);
+            while (q.next())
+                readRow(q, &result.rows);
+        }
+
+        if (!result.windowed) {
+            QList<ProductSearchIndex::Entry> entries;
+            entries.reserve(result.rows.size());
+            for (int i = 0; i < result.rows.size(); i++)
+                entries << qMakePair(result.rows.id(i), result.rows.nameView(i));
+
+            result.searchIndex.build(entries);
+
+            // Saved in code order, the order the next session opens with
+            if (!snapshot.path.isEmpty() && !unchanged) {
+                ProductRowStore saved = result.rows;
+                if (query.sortColumn != Column::Code || query.sortOrder != Qt::AscendingOrder)
+                    sortRows(&saved, Column::Code, Qt::AscendingOrder);
+                ProductListSnapshot::save(snapshot.path, snapshot.databaseKey, saved, result.version);
+            }
+        }
+
+        result.ok = true;
+        return result;
+    }
+
+    // Rebuilds the unfiltered list from the previous one, fetching only rows whose checksum changed on the server
+    static bool reconcile(QSqlQuery& q, const ProductRowStore& previous, ProductRowStore* rows)
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::reconcile");
+
+        if (!Sql::exec(q, QString("select id, %1 from products where %2 order by id")
+                    .arg(ProductListSnapshot::rowChecksumExpression(), Query().whereClause()))) {
             qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
             return false;
         }
-        beginResetModel();
-        items.clear();
 
+        QHash<quint16, int> previousRowById;
+        previousRowById.reserve(previous.size());
+        for (int i = 0; i < previous.size(); i++)
+            previousRowById.insert(previous.id(i), i);
+
+        // Per server row: its row in the previous list, or -1 when it has to be fetched
+        QVector<QPair<quint16, int> > sources;
+        QStringList changedIds;
         while (q.next()) {
-            Item item;
-            item.id = q.value("id").value<quint16>();
-            item.name = q.value("name").toString();
-            item.type = q.value("type").value<quint8>();
-            item.active = q.value("active").toBool();
-            item.code = Product::formatCode(item.id);
-            items << item;
+            quint16 id = q.value(0).value<quint16>();
+            int row = previousRowById.value(id, -1);
+            if (row != -1 && ProductListSnapshot::rowChecksum(previous, row) != q.value(1).toUInt())
+                row = -1;
+            if (row == -1)
+                changedIds << QString::number(id);
+            sources << qMakePair(id, row);
+        }
+
+        ProductRowStore changed;
+        QHash<quint16, int> changedRowById;
+        for (int i = 0; i < changedIds.size(); i += PageSize) {
+            if (!Sql::exec(q, QString("select id, name, type, active from products where id in (%1)")
+                        .arg(changedIds.mid(i, PageSize).join(',')))) {
+                qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+                return false;
+            }
+
+            while (q.next()) {
+                changedRowById.insert(q.value(0).value<quint16>(), changed.size());
+                readRow(q, &changed);
+            }
+        }
+
+        rows->reserve(sources.size());
+        for (const QPair<quint16, int>& source: sources) {
+            if (source.second != -1) {
+                int row = source.second;
+                rows->append(source.first, previous.type(row), previous.isActive(row), previous.nameView(row));
+                continue;
+            }
+
+            // Gone when it was deleted between the two queries
+            int row = changedRowById.value(source.first, -1);
+            if (row != -1)
+                rows->append(source.first, changed.type(row), changed.isActive(row), changed.nameView(row));
         }
-        endResetModel();
 
         return true;
     }
 
+    static FetchResult fetchOne(const Query& query, quint16 id, bool withSearch)
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::fetchOne");
+
+        FetchResult result;
+
+        QSqlDatabase db = ConnectionPool::instance()->database();
+        if (!db.isOpen())
+            return result;
+
+        QSqlQuery q(db);
+        q.setForwardOnly(true);
+        q.prepare(QString("select id, name, type, active from products where id=:id and %1").arg(query.whereClause(withSearch)));
+        q.bindValue(":id", id);
+        query.bindSearch(q, withSearch);
+        if (!Sql::exec(q)) {
+            qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+            return result;
+        }
+
+        if (q.next())
+            readRow(q, &result.rows);
+
+        result.ok = true;
+        return result;
+    }
+
+    static FetchResult fetchPage(const Query& query, int pageIndex)
+    {
+        SIMS_TRACE_SCOPE("ProductListWidget::Model::fetchPage");
+
+        FetchResult result;
+
+        QSqlDatabase db = ConnectionPool::instance()->database();
+        if (!db.isOpen())
+            return result;
+
+        QSqlQuery q(db);
+        q.setForwardOnly(true);
+        q.prepare(QString("select id, name, type, active from products where %1 order by %2 limit %3 offset %4")
+                  .arg(query.whereClause(true), query.orderByClause())
+                  .arg(PageSize).arg(pageIndex * PageSize));
+        query.bindSearch(q, true);
+        if (!Sql::exec(q)) {
+            qDebug() << "SQL ERROR:" << qPrintable(q.lastError().text());
+            return result;
+        }
+
+        result.rows.reserve(PageSize);
+        while (q.next())
+            readRow(q, &result.rows);
+
+        result.ok = true;
+        return result;
+    }
+
+    static void closeConnection()
+    {
+        ConnectionPool::instance()->release();
+    }
+
+    QThreadPool _loaderPool;
+    QFutureWatcher<FetchResult> _watcher;
+    bool _refreshPending;
+    Query _query;
+    QHash<quint16, int> _rowById;
+    bool _snapshotTried;
+    QString _snapshotVersion;
+
+    bool _windowed;
+    int _rowCount;
+    int _generation;
+    mutable QCache<int, Page> _pages;
+    QSet<int> _pendingPages;
+    int _lastPage;
 };
 
 class ProductListWidget::ProxyModel : public QSortFilterProxyModel
@@ -132,7 +912,93 @@ class ProductListWidget::ProxyModel : public QSortFilterProxyModel
 public:
     ProxyModel(QObject* parent)
         : QSortFilterProxyModel(parent)
+        , _searching(false)
     {}
+
+    // Sorting is pushed down to the source model, which asks the database for the new order
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder)
+    {
+        if (sourceModel())
+            sourceModel()->sort(column, order);
+    }
+
+    // Shows only the given products, ordered by their position in the list
+    void setMatches(const QVector<quint16>& ids)
+    {
+        _rankById.clear();
+        _rankById.reserve(ids.size());
+        for (int i = 0; i < ids.size(); i++)
+            _rankById.insert(ids.at(i), i);
+
+        _searching = true;
+        invalidateFilter();
+        QSortFilterProxyModel::sort(0);
+    }
+
+    void clearMatches()
+    {
+        if (!_searching)
+            return;
+
+        _searching = false;
+        _rankById.clear();
+        invalidateFilter();
+        QSortFilterProxyModel::sort(-1);
+    }
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+    {
+        Q_UNUSED(sourceParent)
+        return !_searching || _rankById.contains(static_cast<Model*>(sourceModel())->idAt(sourceRow));
+    }
+
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const
+    {
+        Model* model = static_cast<Model*>(sourceModel());
+        return _rankById.value(model->idAt(left.row())) < _rankById.value(model->idAt(right.row()));
+    }
+
+private:
+    bool _searching;
+    QHash<quint16, int> _rankById;
+};
+
+class ProductListWidget::Delegate : public QStyledItemDelegate
+{
+public:
+    Delegate(ProductListWidget* widget)
+        : QStyledItemDelegate(widget)
+        , _widget(widget)
+    {}
+
+    // Paints straight from the row store, without the QVariant round trip initStyleOption() makes for every role
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+    {
+        QStyleOptionViewItem opt = option;
+        opt.index = index;
+        opt.features |= QStyleOptionViewItem::HasDisplay;
+        opt.displayAlignment = Qt::AlignLeft | Qt::AlignVCenter;
+        opt.textElideMode = Qt::ElideRight;
+
+        const ProductRowStore* store = 0;
+        int row = 0;
+        if (_widget->model->locate(_widget->proxyModel->mapToSource(index).row(), &store, &row)) {
+            switch (index.column()) {
+            case Model::Code: opt.text = store->codeView(row); break;
+            case Model::Name: opt.text = store->nameView(row); break;
+            case Model::Type: opt.text = ProductRowStore::typeString(store->type(row)); break;
+            case Model::Active: opt.text = ProductRowStore::statusString(store->isActive(row)); break;
+            }
+        }
+
+        const QWidget* widget = option.widget;
+        QStyle* style = widget ? widget->style() : QApplication::style();
+        style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+    }
+
+private:
+    ProductListWidget* _widget;
 };
 
 ProductListWidget::ProductListWidget(QWidget *parent)
@@ -143,8 +1009,55 @@ ProductListWidget::ProductListWidget(QWidget *parent)
     connect(refreshAction, SIGNAL(triggered(bool)), SLOT(refresh()));
     QAction* newAction = toolBar->addAction("Tambah");
     connect(newAction, SIGNAL(triggered(bool)), SIGNAL(newActionTriggered()));
+    QAction* repriceAction = toolBar->addAction("Ubah Harga");
+    connect(repriceAction, SIGNAL(triggered(bool)), SIGNAL(repriceActionTriggered()));
+    QAction* importAction = toolBar->addAction("Impor");
+    connect(importAction, SIGNAL(triggered(bool)), SIGNAL(importActionTriggered()));
+    _writeActions << newAction << repriceAction << importAction;
+    QAction* exportAction = toolBar->addAction("Ekspor");
+    connect(exportAction, SIGNAL(triggered(bool)), SIGNAL(exportActionTriggered()));
+
+    QMenu* priceListMenu = new QMenu(toolBar);
+    QAction* printPriceListAction = priceListMenu->addAction("&Cetak...");
+    connect(printPriceListAction, SIGNAL(triggered(bool)), SIGNAL(printPriceListActionTriggered()));
+    QAction* savePriceListAction = priceListMenu->addAction("&Simpan PDF...");
+    connect(savePriceListAction, SIGNAL(triggered(bool)), SIGNAL(savePriceListActionTriggered()));
+    QAction* priceListAction = toolBar->addAction("Daftar Harga");
+    priceListAction->setMenu(priceListMenu);
+    qobject_cast<QToolButton*>(toolBar->widgetForAction(priceListAction))->setPopupMode(QToolButton::InstantPopup);
+    QAction* printLabelsAction = toolBar->addAction("Cetak Label");
+    connect(printLabelsAction, SIGNAL(triggered(bool)), SIGNAL(printLabelsActionTriggered()));
+
+    toolBar->addSeparator();
+
+    _typeFilterComboBox = new QComboBox(toolBar);
+    _typeFilterComboBox->addItem("Semua Jenis", -1);
+    _typeFilterComboBox->addItem(Product::typeString(Product::Type::Stocked), Product::Type::Stocked);
+    _typeFilterComboBox->addItem(Product::typeString(Product::Type::NonStocked), Product::Type::NonStocked);
+    _typeFilterComboBox->addItem(Product::typeString(Product::Type::Service), Product::Type::Service);
+    connect(_typeFilterComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onFilterChanged()));
+    toolBar->addWidget(_typeFilterComboBox);
+
+    _statusFilterComboBox = new QComboBox(toolBar);
+    _statusFilterComboBox->addItem("Semua Status", -1);
+    _statusFilterComboBox->addItem("Aktif", 1);
+    _statusFilterComboBox->addItem("Nonaktif", 0);
+    connect(_statusFilterComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onFilterChanged()));
+    toolBar->addWidget(_statusFilterComboBox);
+
+    _searchEdit = new QLineEdit(toolBar);
+    _searchEdit->setPlaceholderText("Cari nama / kode produk");
+    _searchEdit->setClearButtonEnabled(true);
+    connect(_searchEdit, SIGNAL(textChanged(QString)), SLOT(_applySearch()));
+    toolBar->addWidget(_searchEdit);
+
+    _loadingAction = toolBar->addWidget(new QLabel("Memuat data...", toolBar));
+    _loadingAction->setVisible(false);
 
     model = new Model(this);
+    connect(model, SIGNAL(loadingChanged(bool)), _loadingAction, SLOT(setVisible(bool)));
+    connect(model, SIGNAL(modelReset()), SLOT(_applySearch()));
+    connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(_applySearch()));
     model->refresh();
 
     proxyModel = new ProxyModel(this);
@@ -153,7 +1066,8 @@ ProductListWidget::ProductListWidget(QWidget *parent)
     view = new QTableView(this);
     view->setAlternatingRowColors(true);
     view->setSortingEnabled(true);
-    view->setSelectionMode(QAbstractItemView::SingleSelection);
+    // Several products at once for labels, activating a row still opens one
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
     view->setSelectionBehavior(QAbstractItemView::SelectRows);
     view->horizontalHeader()->setHighlightSections(false);
     view->verticalHeader()->setDefaultSectionSize(20);
@@ -161,6 +1075,8 @@ ProductListWidget::ProductListWidget(QWidget *parent)
     view->verticalHeader()->setMaximumSectionSize(20);
     view->verticalHeader()->setVisible(false);
     view->setModel(proxyModel);
+    view->setItemDelegate(new Delegate(this));
+    view->sortByColumn(Model::Column::Code, Qt::AscendingOrder);
 
     connect(view, SIGNAL(activated(QModelIndex)), SLOT(_onViewActivated(QModelIndex)));
 
@@ -171,11 +1087,73 @@ ProductListWidget::ProductListWidget(QWidget *parent)
     mainLayout->addWidget(view);
 }
 
+QVector<quint16> ProductListWidget::selectedIds(int* skipped) const
+{
+    QModelIndexList indexes = view->selectionModel()->selectedRows();
+    QVector<int> rows;
+    rows.reserve(indexes.size());
+    for (const QModelIndex& index: indexes)
+        rows << proxyModel->mapToSource(index).row();
+    std::sort(rows.begin(), rows.end());
+
+    QVector<quint16> ids;
+    ids.reserve(rows.size());
+    int missing = 0;
+    for (int i = 0; i < rows.size(); ) {
+        quint16 id = model->idAt(rows.at(i));
+        if (id) {
+            ids << id;
+            i++;
+            continue;
+        }
+
+        // Windowed rows whose page is not cached, a shift-click or select-all over the
+        // catalog, are read in one query per consecutive run
+        int end = i + 1;
+        while (end < rows.size() && rows.at(end) == rows.at(end - 1) + 1 && !model->idAt(rows.at(end)))
+            end++;
+
+        int count = end - i;
+        QVector<quint16> runIds;
+        if (model->fetchIds(rows.at(i), count, &runIds))
+            ids << runIds;
+        missing += count - runIds.size();
+        i = end;
+    }
+
+    if (skipped)
+        *skipped = missing;
+    return ids;
+}
+
 void ProductListWidget::_onViewActivated(const QModelIndex& index)
 {
     QModelIndex srcIndex = proxyModel->mapToSource(index);
-    Model::Item item = model->items.at(srcIndex.row());
-    emit activated(item.id);
+    quint16 id = model->idAt(srcIndex.row());
+    if (id)
+        emit activated(id);
+}
+
+void ProductListWidget::_applySearch()
+{
+    QString text = _searchEdit->text().trimmed();
+    model->setSearch(text);
+
+    if (model->isWindowed() || text.isEmpty())
+        proxyModel->clearMatches();
+    else
+        proxyModel->setMatches(model->searchIndex.search(text, MaxSearchResults));
+}
+
+void ProductListWidget::_onFilterChanged()
+{
+    model->setFilter(_typeFilterComboBox->currentData().toInt(), _statusFilterComboBox->currentData().toInt());
+}
+
+void ProductListWidget::setReadOnly(bool readOnly)
+{
+    for (QAction* action: _writeActions)
+        action->setEnabled(!readOnly);
 }
 
 void ProductListWidget::refresh()
@@ -183,4 +1161,14 @@ void ProductListWidget::refresh()
     model->refresh();
 }
 
+void ProductListWidget::upsertProduct(quint16 id)
+{
+    model->upsert(id);
+}
+
+void ProductListWidget::removeProduct(quint16 id)
+{
+    model->remove(id);
+}
+
 #include "productlistwidget.moc"
@@ -3,6 +3,10 @@
 
 #include <QTableView>
 
+class QAction;
+class QComboBox;
+class QLineEdit;
+
 class ProductListWidget : public QWidget
 {
     Q_OBJECT
@@ -10,6 +14,7 @@ class ProductListWidget : public QWidget
 private:
     class Model;
     class ProxyModel;
+    class Delegate;
 
 public:
     QTableView* view;
@@ -18,15 +23,39 @@ public:
 
     ProductListWidget(QWidget *parent = 0);
 
+    // Selected products in the order they are shown. Windowed rows that are not
+    // loaded yet are looked up in the database; skipped counts rows that could not be.
+    QVector<quint16> selectedIds(int* skipped = 0) const;
+
+    // Disables the actions that change products, the list itself stays usable
+    void setReadOnly(bool readOnly);
+
 signals:
     void newActionTriggered();
+    void repriceActionTriggered();
+    void importActionTriggered();
+    void exportActionTriggered();
+    void printPriceListActionTriggered();
+    void savePriceListActionTriggered();
+    void printLabelsActionTriggered();
     void activated(quint16 id);
 
 private slots:
     void _onViewActivated(const QModelIndex& index);
+    void _onFilterChanged();
+    void _applySearch();
 
 public slots:
     void refresh();
+    void upsertProduct(quint16 id);
+    void removeProduct(quint16 id);
+
+private:
+    QList<QAction*> _writeActions;
+    QAction* _loadingAction;
+    QComboBox* _typeFilterComboBox;
+    QComboBox* _statusFilterComboBox;
+    QLineEdit* _searchEdit;
 };
 
 #endif // PRODUCTLISTWIDGET_H
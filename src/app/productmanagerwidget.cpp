@@ -1,17 +1,43 @@
 #include "productmanagerwidget.h"
 #include "producteditor.h"
 #include "productlistwidget.h"
+#include "repricedialog.h"
+#include "productimportdialog.h"
+#include "productexporter.h"
+#include "pricelistprinter.h"
+#include "labeldialog.h"
+#include "backgroundjobdialog.h"
+#include "trace.h"
 
 #include <QTabWidget>
+#include <QApplication>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QPrinter>
+#include <QPrintDialog>
+#include <QTimer>
+#include <QLocale>
+
+// More closed editors than this are deleted, a burst of closed tabs shouldn't pin memory
+static const int MaxSpareEditors = 4;
+// Spares are built once the tab that was just opened has been painted
+static const int SpareEditorDelay = 250;
 
 ProductManagerWidget::ProductManagerWidget(QWidget *parent)
     : QSplitter(parent)
+    , _readOnly(false)
 {
     setWindowTitle("Produk");
 
     _listWidget = new ProductListWidget(this);
     connect(_listWidget, SIGNAL(newActionTriggered()), SLOT(newProduct()));
     connect(_listWidget, SIGNAL(activated(quint16)), SLOT(editProduct(quint16)));
+    connect(_listWidget, SIGNAL(repriceActionTriggered()), SLOT(repriceProducts()));
+    connect(_listWidget, SIGNAL(importActionTriggered()), SLOT(importProducts()));
+    connect(_listWidget, SIGNAL(exportActionTriggered()), SLOT(exportProducts()));
+    connect(_listWidget, SIGNAL(printPriceListActionTriggered()), SLOT(printPriceList()));
+    connect(_listWidget, SIGNAL(savePriceListActionTriggered()), SLOT(savePriceList()));
+    connect(_listWidget, SIGNAL(printLabelsActionTriggered()), SLOT(printLabels()));
 
     _editorsTabWidget = new QTabWidget(this);
     _editorsTabWidget->setDocumentMode(true);
@@ -22,6 +48,28 @@ ProductManagerWidget::ProductManagerWidget(QWidget *parent)
 
     setCollapsible(0, false);
     setCollapsible(1, false);
+
+    QTimer::singleShot(SpareEditorDelay, this, SLOT(_prepareSpareEditor()));
+}
+
+void ProductManagerWidget::setReadOnly(bool readOnly)
+{
+    if (_readOnly == readOnly)
+        return;
+
+    _readOnly = readOnly;
+    _listWidget->setReadOnly(readOnly);
+
+    // The rows so far may only be the snapshot
+    if (!readOnly)
+        _listWidget->refresh();
+}
+
+bool ProductManagerWidget::checkWritable()
+{
+    if (_readOnly)
+        QMessageBox::information(0, "Informasi", "Database belum terhubung, data produk hanya dapat dilihat.");
+    return !_readOnly;
 }
 
 bool ProductManagerWidget::closeTab(int index)
@@ -35,7 +83,7 @@ bool ProductManagerWidget::closeTab(int index)
     if (_editorByIds.contains(editor->id))
         _editorByIds.remove(editor->id);
 
-    delete editor;
+    releaseEditor(editor);
 
     if (_editorsTabWidget->count() == 0) {
         _editorsTabWidget->hide();
@@ -55,16 +103,23 @@ void ProductManagerWidget::closeAllTabs()
 
 void ProductManagerWidget::newProduct()
 {
-    ProductEditor *editor = new ProductEditor(_editorsTabWidget);
+    if (!checkWritable())
+        return;
+
+    ProductEditor *editor = takeEditor();
     setupTab(editor);
     handleEditorSignals(editor);
+    QTimer::singleShot(0, editor->ui->nameEdit, SLOT(setFocus()));
 }
 
 void ProductManagerWidget::duplicateProduct(quint16 fromId)
 {
-    ProductEditor *editor = new ProductEditor(_editorsTabWidget);
+    if (!checkWritable())
+        return;
+
+    ProductEditor *editor = takeEditor();
     if (!editor->duplicateFrom(fromId)) {
-        delete editor;
+        releaseEditor(editor);
         return;
     }
 
@@ -74,6 +129,8 @@ void ProductManagerWidget::duplicateProduct(quint16 fromId)
 
 void ProductManagerWidget::editProduct(quint16 id)
 {
+    SIMS_TRACE_SCOPE("ProductManagerWidget::editProduct");
+
     QWidget* existingWidget = _editorByIds.value(id, 0);
 
     if (existingWidget) {
@@ -81,9 +138,12 @@ void ProductManagerWidget::editProduct(quint16 id)
         return;
     }
 
-    ProductEditor *editor = new ProductEditor(_editorsTabWidget);
+    if (!checkWritable())
+        return;
+
+    ProductEditor *editor = takeEditor();
     if (!editor->load(id)) {
-        delete editor;
+        releaseEditor(editor);
         return;
     }
 
@@ -92,6 +152,150 @@ void ProductManagerWidget::editProduct(quint16 id)
     handleEditorSignals(editor);
 }
 
+void ProductManagerWidget::repriceProducts()
+{
+    if (!checkWritable())
+        return;
+
+    RepriceDialog dialog(this);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    // Open editors would write their old prices back on the next save
+    for (quint16 id: dialog.changedProductIds()) {
+        ProductEditor* editor = qobject_cast<ProductEditor*>(_editorByIds.value(id, 0));
+        if (editor)
+            editor->load(id);
+    }
+}
+
+void ProductManagerWidget::importProducts()
+{
+    if (!checkWritable())
+        return;
+
+    ProductImportDialog dialog(this);
+    dialog.exec();
+
+    if (dialog.importedCount())
+        _listWidget->refresh();
+}
+
+void ProductManagerWidget::exportProducts()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Ekspor Produk", "produk.xlsx",
+                                                "Excel (*.xlsx);;CSV (*.csv)");
+    if (path.isEmpty())
+        return;
+
+    BackgroundJobDialog dialog("Ekspor Produk", "Mengekspor %1 dari %2 produk...",
+                               [path](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+        return ProductExporter::exportTo(path, ProductExporter::formatForPath(path), progress, error);
+    }, this);
+    if (dialog.exec() == QDialog::Accepted)
+        QMessageBox::information(0, "Informasi", QString("Produk telah diekspor ke %1.").arg(path));
+    else if (!dialog.wasCanceled())
+        QMessageBox::warning(0, "Peringatan", QString("Ekspor gagal: %1").arg(dialog.errorString()));
+}
+
+void ProductManagerWidget::printPriceList()
+{
+    QPrinter printer(QPrinter::HighResolution);
+    printer.setDocName("Daftar Harga");
+    printer.setPageSize(QPageSize(QPageSize::A4));
+
+    QPrintDialog printDialog(&printer, this);
+    if (printDialog.exec() != QDialog::Accepted)
+        return;
+
+    // Printing to a file keeps the text, real printers get ready made bitmaps
+    bool raster = printer.outputFormat() == QPrinter::NativeFormat;
+    QPrinter* device = &printer;
+    BackgroundJobDialog dialog("Cetak Daftar Harga", "Mencetak %1 dari %2 produk...",
+                               [device, raster](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+        return PriceListPrinter::print(device, raster, progress, error);
+    }, this);
+    if (dialog.exec() != QDialog::Accepted && !dialog.wasCanceled())
+        QMessageBox::warning(0, "Peringatan", QString("Pencetakan gagal: %1").arg(dialog.errorString()));
+}
+
+void ProductManagerWidget::savePriceList()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Simpan Daftar Harga", "daftar-harga.pdf", "PDF (*.pdf)");
+    if (path.isEmpty())
+        return;
+
+    BackgroundJobDialog dialog("Simpan Daftar Harga", "Menyusun %1 dari %2 produk...",
+                               [path](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+        return PriceListPrinter::printToPdf(path, progress, error);
+    }, this);
+    if (dialog.exec() == QDialog::Accepted)
+        QMessageBox::information(0, "Informasi", QString("Daftar harga telah disimpan ke %1.").arg(path));
+    else if (!dialog.wasCanceled())
+        QMessageBox::warning(0, "Peringatan", QString("Daftar harga gagal disimpan: %1").arg(dialog.errorString()));
+}
+
+void ProductManagerWidget::printLabels()
+{
+    int skipped = 0;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QVector<quint16> ids = _listWidget->selectedIds(&skipped);
+    QApplication::restoreOverrideCursor();
+
+    if (skipped) {
+        if (QMessageBox::question(0, "Konfirmasi",
+                                  QString("%1 produk yang dipilih tidak dapat dimuat dan tidak akan dicetak. Lanjutkan?")
+                                  .arg(QLocale().toString(skipped)), "&Ya", "&Tidak"))
+            return;
+    }
+
+    if (ids.isEmpty()) {
+        QMessageBox::information(0, "Informasi", "Pilih produk yang akan dicetak labelnya.");
+        return;
+    }
+
+    LabelDialog labelDialog(ids.size(), this);
+    if (labelDialog.exec() != QDialog::Accepted)
+        return;
+
+    LabelPrinter::Options options = labelDialog.options();
+
+    if (labelDialog.destination() == LabelDialog::Pdf) {
+        QString path = QFileDialog::getSaveFileName(this, "Simpan Label", "label-harga.pdf", "PDF (*.pdf)");
+        if (path.isEmpty())
+            return;
+
+        BackgroundJobDialog dialog("Simpan Label", "Menyusun %1 dari %2 label...",
+                                   [path, options, ids](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+            return LabelPrinter::printToPdf(path, options, ids, progress, error);
+        }, this);
+        if (dialog.exec() == QDialog::Accepted)
+            QMessageBox::information(0, "Informasi", QString("Label telah disimpan ke %1.").arg(path));
+        else if (!dialog.wasCanceled())
+            QMessageBox::warning(0, "Peringatan", QString("Label gagal disimpan: %1").arg(dialog.errorString()));
+        return;
+    }
+
+    // Label positions are measured from the edge of the sheet, not from the printer's margins
+    QPrinter printer(QPrinter::HighResolution);
+    printer.setDocName("Label Harga");
+    printer.setPageSize(QPageSize(options.sheet.pageSize));
+    printer.setFullPage(true);
+
+    QPrintDialog printDialog(&printer, this);
+    if (printDialog.exec() != QDialog::Accepted)
+        return;
+
+    bool raster = printer.outputFormat() == QPrinter::NativeFormat;
+    QPrinter* device = &printer;
+    BackgroundJobDialog dialog("Cetak Label", "Mencetak %1 dari %2 label...",
+                               [device, raster, options, ids](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+        return LabelPrinter::print(device, raster, options, ids, progress, error);
+    }, this);
+    if (dialog.exec() != QDialog::Accepted && !dialog.wasCanceled())
+        QMessageBox::warning(0, "Peringatan", QString("Pencetakan gagal: %1").arg(dialog.errorString()));
+}
+
 void ProductManagerWidget::setupTab(QWidget* widget)
 {
     int index = _editorsTabWidget->addTab(widget, widget->windowIcon(), widget->windowTitle());
@@ -101,6 +305,48 @@ void ProductManagerWidget::setupTab(QWidget* widget)
     }
 }
 
+ProductEditor* ProductManagerWidget::takeEditor()
+{
+    // Building an editor costs more than loading a product, so the next one is made while idle
+    QTimer::singleShot(SpareEditorDelay, this, SLOT(_prepareSpareEditor()));
+
+    if (!_spareEditors.isEmpty())
+        return _spareEditors.takeLast();
+
+    return new ProductEditor(_editorsTabWidget);
+}
+
+void ProductManagerWidget::releaseEditor(ProductEditor* editor)
+{
+    int index = _editorsTabWidget->indexOf(editor);
+    if (index != -1)
+        _editorsTabWidget->removeTab(index);
+
+    if (_spareEditors.size() >= MaxSpareEditors) {
+        delete editor;
+        return;
+    }
+
+    disconnect(editor, 0, this, 0);
+    disconnect(editor, 0, _listWidget, 0);
+    editor->hide();
+    editor->reset();
+    _spareEditors << editor;
+}
+
+void ProductManagerWidget::_prepareSpareEditor()
+{
+    if (!_spareEditors.isEmpty())
+        return;
+
+    SIMS_TRACE_SCOPE("ProductManagerWidget::prepareSpareEditor");
+
+    ProductEditor* editor = new ProductEditor(_editorsTabWidget);
+    editor->hide();
+    editor->ensurePolished();
+    _spareEditors << editor;
+}
+
 void ProductManagerWidget::updateTabText(const QString& title)
 {
     QWidget* widget = qobject_cast<QWidget*>(sender());
@@ -111,14 +357,14 @@ void ProductManagerWidget::updateTabText(const QString& title)
 void ProductManagerWidget::handleEditorSignals(ProductEditor* editor)
 {
     connect(editor, SIGNAL(duplicateRequested(quint16)), SLOT(duplicateProduct(quint16)));
-    connect(editor, SIGNAL(saved(quint16)), _listWidget, SLOT(refresh()));
-    connect(editor, SIGNAL(removed(quint16)), SLOT(handleProductRemoved()));
+    connect(editor, SIGNAL(saved(quint16)), _listWidget, SLOT(upsertProduct(quint16)));
+    connect(editor, SIGNAL(removed(quint16)), SLOT(handleProductRemoved(quint16)));
     connect(editor, SIGNAL(windowTitleChanged(QString)), SLOT(updateTabText(QString)));
 }
 
-void ProductManagerWidget::handleProductRemoved()
+void ProductManagerWidget::handleProductRemoved(quint16 id)
 {
-    _listWidget->refresh();
+    _listWidget->removeProduct(id);
     ProductEditor* editor = qobject_cast<ProductEditor*>(sender());
     closeTab(_editorsTabWidget->indexOf(editor));
 }
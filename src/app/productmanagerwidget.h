@@ -14,12 +14,22 @@ class ProductManagerWidget : public QSplitter
 public:
     explicit ProductManagerWidget(QWidget *parent = 0);
 
+    // While the database is not connected the list shows the local snapshot and
+    // nothing can be opened or changed. Going back to writable refreshes the list.
+    void setReadOnly(bool readOnly);
+
 signals:
 
 public slots:
     void newProduct();
     void editProduct(quint16 id);
     void duplicateProduct(quint16 fromId);
+    void repriceProducts();
+    void importProducts();
+    void exportProducts();
+    void printPriceList();
+    void savePriceList();
+    void printLabels();
 
     bool closeTab(int index);
     void closeAllTabs();
@@ -27,16 +37,23 @@ public slots:
 private:
     void setupTab(QWidget* widget);
     void handleEditorSignals(ProductEditor* editor);
+    ProductEditor* takeEditor();
+    void releaseEditor(ProductEditor* editor);
+    bool checkWritable();
 
 
 private slots:
     void updateTabText(const QString& title);
-    void handleProductRemoved();
+    void handleProductRemoved(quint16 id);
+    void _prepareSpareEditor();
 
 private:
+    bool _readOnly;
     ProductListWidget* _listWidget;
     QTabWidget* _editorsTabWidget;
     QHash<quint16, QWidget*> _editorByIds;
+    // Closed editors, reset and waiting to be opened again
+    QList<ProductEditor*> _spareEditors;
 };
 
 #endif // PRODUCTMANAGERWIDGET_H
@@ -0,0 +1,154 @@
+#include "productrowstore.h"
+
+ProductRowStore::ProductRowStore()
+    : _wasted(0)
+{
+}
+
+void ProductRowStore::reserve(int size, int nameLength)
+{
+    _ids.reserve(size);
+    _types.reserve(size);
+    _flags.reserve(size);
+    _nameOffsets.reserve(size);
+    _nameLengths.reserve(size);
+    _names.reserve(size * nameLength);
+}
+
+void ProductRowStore::clear()
+{
+    _ids.clear();
+    _types.clear();
+    _flags.clear();
+    _nameOffsets.clear();
+    _nameLengths.clear();
+    _names.clear();
+    _wasted = 0;
+}
+
+void ProductRowStore::append(quint16 id, quint8 type, bool active, const QString& name)
+{
+    _ids << id;
+    _types << type;
+    _flags << quint8(active ? ActiveFlag : 0);
+    _nameOffsets << quint32(_names.size());
+    _nameLengths << quint16(name.size());
+    _names += name;
+}
+
+void ProductRowStore::set(int row, quint8 type, bool active, const QString& name)
+{
+    _types[row] = type;
+    _flags[row] = quint8(active ? ActiveFlag : 0);
+    storeName(row, name);
+}
+
+void ProductRowStore::removeAt(int row)
+{
+    _wasted += _nameLengths.at(row);
+
+    _ids.remove(row);
+    _types.remove(row);
+    _flags.remove(row);
+    _nameOffsets.remove(row);
+    _nameLengths.remove(row);
+
+    if (_wasted > _names.size() / 2)
+        compact();
+}
+
+QString ProductRowStore::name(int row) const
+{
+    return QString(_names.constData() + _nameOffsets.at(row), _nameLengths.at(row));
+}
+
+QString ProductRowStore::code(int row) const
+{
+    QChar buffer[CodeLength];
+    formatCode(_ids.at(row), buffer);
+    return QString(buffer, CodeLength);
+}
+
+QString ProductRowStore::nameView(int row) const
+{
+    return QString::fromRawData(_names.constData() + _nameOffsets.at(row), _nameLengths.at(row));
+}
+
+QString ProductRowStore::codeView(int row) const
+{
+    formatCode(_ids.at(row), _codeBuffer);
+    return QString::fromRawData(_codeBuffer, CodeLength);
+}
+
+const QString& ProductRowStore::typeString(quint8 type)
+{
+    static const QString stocked("Stok");
+    static const QString nonStocked("Non Stok");
+    static const QString service("Jasa");
+    static const QString voucher("Voucher ShiftNet");
+    static const QString unknown;
+
+    switch (type) {
+    case 0: return stocked;
+    case 1: return nonStocked;
+    case 2: return service;
+    case 255: return voucher;
+    }
+
+    return unknown;
+}
+
+const QString& ProductRowStore::statusString(bool active)
+{
+    static const QString activeString("Aktif");
+    static const QString inactiveString("Nonaktif");
+
+    return active ? activeString : inactiveString;
+}
+
+void ProductRowStore::formatCode(quint16 id, QChar* buffer)
+{
+    // Same format as Product::formatCode(), without going through QString::arg()
+    buffer[0] = QChar('P');
+    buffer[1] = QChar('-');
+    for (int i = CodeLength - 1; i >= 2; i--) {
+        buffer[i] = QChar('0' + id % 10);
+        id /= 10;
+    }
+}
+
+void ProductRowStore::storeName(int row, const QString& name)
+{
+    quint32 offset = _nameOffsets.at(row);
+    int length = _nameLengths.at(row);
+
+    // Shorter or equal names reuse their slot, longer ones move to the end of the arena
+    if (name.size() <= length) {
+        _names.replace(int(offset), name.size(), name);
+        _wasted += length - name.size();
+    }
+    else {
+        _wasted += length;
+        _nameOffsets[row] = quint32(_names.size());
+        _names += name;
+    }
+    _nameLengths[row] = quint16(name.size());
+
+    if (_wasted > _names.size() / 2)
+        compact();
+}
+
+void ProductRowStore::compact()
+{
+    QString names;
+    names.reserve(_names.size() - _wasted);
+
+    for (int row = 0; row < _ids.size(); row++) {
+        quint32 offset = quint32(names.size());
+        names.append(_names.constData() + _nameOffsets.at(row), _nameLengths.at(row));
+        _nameOffsets[row] = offset;
+    }
+
+    _names.swap(names);
+    _wasted = 0;
+}
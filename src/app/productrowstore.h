@@ -0,0 +1,65 @@
+#ifndef PRODUCTROWSTORE_H
+#define PRODUCTROWSTORE_H
+
+#include <QString>
+#include <QVector>
+
+// Column-wise storage for product list rows.
+// Ids, types and flags live in their own arrays and every name is packed
+// into a single UTF-16 arena, so a row costs a few bytes plus its name.
+// Codes are not stored, they are formatted from the id when asked for.
+class ProductRowStore
+{
+public:
+    static const int CodeLength = 7;
+
+    ProductRowStore();
+
+    int size() const { return _ids.size(); }
+    bool isEmpty() const { return _ids.isEmpty(); }
+
+    void reserve(int size, int nameLength = 24);
+    void clear();
+
+    void append(quint16 id, quint8 type, bool active, const QString& name);
+    void set(int row, quint8 type, bool active, const QString& name);
+    void removeAt(int row);
+
+    quint16 id(int row) const { return _ids.at(row); }
+    quint8 type(int row) const { return _types.at(row); }
+    bool isActive(int row) const { return _flags.at(row) & ActiveFlag; }
+
+    // Copies, safe to keep around
+    QString name(int row) const;
+    QString code(int row) const;
+
+    // Views into the arena and the code buffer, only valid until the store or the next codeView() call changes them
+    QString nameView(int row) const;
+    QString codeView(int row) const;
+
+    static const QString& typeString(quint8 type);
+    static const QString& statusString(bool active);
+    static void formatCode(quint16 id, QChar* buffer);
+
+private:
+    friend class ProductListSnapshot;
+
+    enum Flag {
+        ActiveFlag = 0x01
+    };
+
+    void storeName(int row, const QString& name);
+    void compact();
+
+    QVector<quint16> _ids;
+    QVector<quint8> _types;
+    QVector<quint8> _flags;
+    QVector<quint32> _nameOffsets;
+    QVector<quint16> _nameLengths;
+    QString _names;
+    int _wasted;
+
+    mutable QChar _codeBuffer[CodeLength];
+};
+
+#endif // PRODUCTROWSTORE_H
@@ -0,0 +1,316 @@
+#include "productsearchindex.h"
+
+#include <algorithm>
+
+namespace {
+
+const int IdSpace = 65536;
+const int CodeDigits = 5;
+
+bool tokenTextLessThan(const QString& text, const QString& other)
+{
+    return text < other;
+}
+
+}
+
+ProductSearchIndex::ProductSearchIndex()
+    : _names(IdSpace)
+    , _present(IdSpace)
+    , _size(0)
+{
+}
+
+void ProductSearchIndex::clear()
+{
+    _tokens.clear();
+    _postings.clear();
+    _names = QVector<QString>(IdSpace);
+    _present = QBitArray(IdSpace);
+    _size = 0;
+}
+
+void ProductSearchIndex::build(const QList<Entry>& entries)
+{
+    clear();
+    _tokens.reserve(entries.size() * 3);
+
+    // Append everything unsorted, then sort once instead of inserting in order
+    for (const Entry& entry: entries) {
+        quint16 id = entry.first;
+        if (_present.testBit(id))
+            continue;
+
+        QStringList words = tokenize(entry.second);
+        _names[id] = words.join(' ');
+        _present.setBit(id);
+        _size++;
+
+        for (int i = 0; i < words.size(); i++) {
+            Token token;
+            token.text = words.at(i);
+            token.id = id;
+            token.position = quint8(qMin(i, 255));
+            _tokens << token;
+
+            for (quint64 gram: trigrams(words.at(i)))
+                _postings[gram] << id;
+        }
+    }
+
+    std::sort(_tokens.begin(), _tokens.end());
+
+    for (QHash<quint64, QVector<quint16> >::iterator it = _postings.begin(); it != _postings.end(); ++it) {
+        QVector<quint16>& ids = it.value();
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        ids.squeeze();
+    }
+}
+
+void ProductSearchIndex::insert(quint16 id, const QString& name)
+{
+    remove(id);
+
+    QStringList words = tokenize(name);
+    _names[id] = words.join(' ');
+    _present.setBit(id);
+    _size++;
+
+    for (int i = 0; i < words.size(); i++) {
+        Token token;
+        token.text = words.at(i);
+        token.id = id;
+        token.position = quint8(qMin(i, 255));
+        _tokens.insert(std::lower_bound(_tokens.begin(), _tokens.end(), token), token);
+
+        for (quint64 gram: trigrams(words.at(i))) {
+            QVector<quint16>& ids = _postings[gram];
+            QVector<quint16>::iterator it = std::lower_bound(ids.begin(), ids.end(), id);
+            if (it == ids.end() || *it != id)
+                ids.insert(it, id);
+        }
+    }
+}
+
+void ProductSearchIndex::remove(quint16 id)
+{
+    if (!_present.testBit(id))
+        return;
+
+    QStringList words = _names.at(id).split(' ', QString::SkipEmptyParts);
+    for (const QString& word: words) {
+        Token key;
+        key.text = word;
+        key.id = id;
+        QVector<Token>::iterator it = std::lower_bound(_tokens.begin(), _tokens.end(), key);
+        if (it != _tokens.end() && it->id == id && it->text == word)
+            _tokens.erase(it);
+
+        for (quint64 gram: trigrams(word)) {
+            QHash<quint64, QVector<quint16> >::iterator posting = _postings.find(gram);
+            if (posting == _postings.end())
+                continue;
+
+            QVector<quint16>& ids = posting.value();
+            QVector<quint16>::iterator idIt = std::lower_bound(ids.begin(), ids.end(), id);
+            if (idIt != ids.end() && *idIt == id)
+                ids.erase(idIt);
+            if (ids.isEmpty())
+                _postings.erase(posting);
+        }
+    }
+
+    _names[id] = QString();
+    _present.clearBit(id);
+    _size--;
+}
+
+QVector<quint16> ProductSearchIndex::search(const QString& text, int limit) const
+{
+    QStringList terms = tokenize(text);
+    quint32 code = 0;
+    int digits = 0;
+    bool isCode = parseCode(text, &code, &digits);
+
+    if ((terms.isEmpty() && !isCode) || _size == 0)
+        return QVector<quint16>();
+
+    if (_score.isEmpty()) {
+        _score.fill(0, IdSpace);
+        _termScore.fill(0, IdSpace);
+        _matched.fill(0, IdSpace);
+        _hits.fill(0, IdSpace);
+    }
+
+    QVector<quint16> touched;
+    QVector<quint16> termTouched;
+    QVector<quint16> hitTouched;
+
+    for (const QString& term: terms) {
+        termTouched.clear();
+
+        // Word prefix matches, a whole word and the first word of the name rank higher
+        QVector<Token>::const_iterator it = std::lower_bound(_tokens.constBegin(), _tokens.constEnd(), term,
+                                                             [](const Token& token, const QString& t) {
+            return tokenTextLessThan(token.text, t);
+        });
+        for (; it != _tokens.constEnd() && it->text.startsWith(term); ++it) {
+            float score = it->text.size() == term.size() ? 3.0f : 2.0f;
+            if (it->position == 0)
+                score += 0.5f;
+            if (_termScore.at(it->id) == 0)
+                termTouched << it->id;
+            _termScore[it->id] = qMax(_termScore.at(it->id), score);
+        }
+
+        // Trigram overlap tolerates a mistyped, missing or extra letter
+        if (term.size() >= 3) {
+            QVector<quint64> grams = trigrams(term);
+            // About half the trigrams and never a single one, which a short common
+            // fragment like "an" would give to most of the catalog
+            int required = qMin(grams.size(), qMax(2, (grams.size() + 1) / 2));
+
+            hitTouched.clear();
+            for (quint64 gram: grams) {
+                QHash<quint64, QVector<quint16> >::const_iterator posting = _postings.constFind(gram);
+                if (posting == _postings.constEnd())
+                    continue;
+                for (quint16 id: posting.value()) {
+                    if (_hits.at(id) == 0)
+                        hitTouched << id;
+                    _hits[id]++;
+                }
+            }
+
+            for (quint16 id: hitTouched) {
+                if (_hits.at(id) >= required) {
+                    float score = 1.5f * _hits.at(id) / grams.size();
+                    if (_termScore.at(id) == 0)
+                        termTouched << id;
+                    _termScore[id] = qMax(_termScore.at(id), score);
+                }
+                _hits[id] = 0;
+            }
+        }
+
+        for (quint16 id: termTouched) {
+            if (_matched.at(id) == 0 && _score.at(id) == 0)
+                touched << id;
+            _matched[id]++;
+            _score[id] += _termScore.at(id);
+            _termScore[id] = 0;
+        }
+    }
+
+    // Codes are five digits, so the typed digits are either the id itself or a leading part of the code
+    QVector<quint16> codeTouched;
+    if (isCode) {
+        quint32 scale = 1;
+        for (int i = digits; i < CodeDigits; i++)
+            scale *= 10;
+
+        quint32 first = code * scale;
+        quint32 last = qMin<quint32>((code + 1) * scale - 1, IdSpace - 1);
+        for (quint32 id = first; id <= last; id++) {
+            if (_present.testBit(int(id))) {
+                _termScore[id] = 5.0f;
+                codeTouched << quint16(id);
+            }
+        }
+
+        if (code < quint32(IdSpace) && _present.testBit(int(code))) {
+            if (_termScore.at(code) == 0)
+                codeTouched << quint16(code);
+            _termScore[code] = 10.0f;
+        }
+    }
+
+    // Every name term has to match, unless the text matched a code
+    QVector<QPair<float, quint16> > results;
+    for (quint16 id: touched) {
+        if (_matched.at(id) == terms.size())
+            results << qMakePair(_score.at(id) + _termScore.at(id), id);
+    }
+    for (quint16 id: codeTouched) {
+        if (_matched.at(id) != terms.size())
+            results << qMakePair(_score.at(id) + _termScore.at(id), id);
+    }
+
+    for (quint16 id: touched) {
+        _score[id] = 0;
+        _matched[id] = 0;
+    }
+    for (quint16 id: codeTouched)
+        _termScore[id] = 0;
+
+    // Best score first, then shorter names, then lower ids
+    const QVector<QString>& names = _names;
+    auto lessThan = [&names](const QPair<float, quint16>& a, const QPair<float, quint16>& b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+        if (names.at(a.second).size() != names.at(b.second).size())
+            return names.at(a.second).size() < names.at(b.second).size();
+        return a.second < b.second;
+    };
+
+    int count = qMin(limit, results.size());
+    std::partial_sort(results.begin(), results.begin() + count, results.end(), lessThan);
+
+    QVector<quint16> ids;
+    ids.reserve(count);
+    for (int i = 0; i < count; i++)
+        ids << results.at(i).second;
+
+    return ids;
+}
+
+QStringList ProductSearchIndex::tokenize(const QString& text)
+{
+    QString normalized = text.toLower();
+    for (QChar& c: normalized) {
+        if (!c.isLetterOrNumber())
+            c = QChar(' ');
+    }
+
+    return normalized.split(' ', QString::SkipEmptyParts);
+}
+
+bool ProductSearchIndex::parseCode(const QString& text, quint32* value, int* digits)
+{
+    QString code = text.trimmed().toUpper();
+    if (code.startsWith("P-"))
+        code = code.mid(2);
+    else if (code.startsWith('P'))
+        code = code.mid(1);
+
+    if (code.isEmpty() || code.size() > CodeDigits)
+        return false;
+
+    bool ok = false;
+    quint32 number = code.toUInt(&ok);
+    if (!ok)
+        return false;
+
+    *value = number;
+    *digits = code.size();
+    return true;
+}
+
+QVector<quint64> ProductSearchIndex::trigrams(const QString& word)
+{
+    QVector<quint64> grams;
+
+    // Padding makes the first and last letters count as their own trigrams
+    QString padded = QChar(' ') + word + QChar(' ');
+    grams.reserve(padded.size());
+    for (int i = 0; i + 2 < padded.size(); i++) {
+        grams << ((quint64(padded.at(i).unicode()) << 32)
+                  | (quint64(padded.at(i + 1).unicode()) << 16)
+                  | quint64(padded.at(i + 2).unicode()));
+    }
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
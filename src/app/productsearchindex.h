@@ -0,0 +1,61 @@
+#ifndef PRODUCTSEARCHINDEX_H
+#define PRODUCTSEARCHINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Type-ahead index over product names and P-xxxxx codes.
+// Name words are matched by prefix, and by shared trigrams so a mistyped
+// letter still finds the product. Results are ranked best first.
+class ProductSearchIndex
+{
+public:
+    typedef QPair<quint16, QString> Entry;
+
+    ProductSearchIndex();
+
+    void build(const QList<Entry>& entries);
+    void insert(quint16 id, const QString& name);
+    void remove(quint16 id);
+    void clear();
+
+    int size() const { return _size; }
+
+    QVector<quint16> search(const QString& text, int limit) const;
+
+    static QStringList tokenize(const QString& text);
+    static bool parseCode(const QString& text, quint32* value, int* digits);
+
+private:
+    struct Token
+    {
+        QString text;
+        quint16 id;
+        quint8 position;
+
+        bool operator<(const Token& other) const
+        {
+            return text < other.text || (text == other.text && id < other.id);
+        }
+    };
+
+    static QVector<quint64> trigrams(const QString& word);
+
+    QVector<Token> _tokens;
+    QHash<quint64, QVector<quint16> > _postings;
+    QVector<QString> _names;
+    QBitArray _present;
+    int _size;
+
+    // Per query scratch space indexed by product id, reset after every search
+    mutable QVector<float> _score;
+    mutable QVector<float> _termScore;
+    mutable QVector<quint8> _matched;
+    mutable QVector<quint8> _hits;
+};
+
+#endif // PRODUCTSEARCHINDEX_H
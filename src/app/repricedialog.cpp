@@ -0,0 +1,315 @@
+#include "repricedialog.h"
+#include "bulkrepricer.h"
+#include "product.h"
+#include "backgroundjobdialog.h"
+
+#include <QAbstractTableModel>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QTableView>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QGridLayout>
+#include <QBoxLayout>
+#include <QMessageBox>
+#include <QSet>
+
+class RepriceDialog::Model : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    struct Column {
+        enum {
+            Code,
+            Name,
+            Quantity,
+            Price1,
+            Price2,
+            Price3,
+            Count
+        };
+    };
+
+    QVector<BulkRepricer::Change> changes;
+
+    Model(QObject* parent)
+        : QAbstractTableModel(parent)
+    {
+    }
+
+    void setChanges(QVector<BulkRepricer::Change>& newChanges)
+    {
+        beginResetModel();
+        changes.swap(newChanges);
+        endResetModel();
+    }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : changes.size();
+    }
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : Column::Count;
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const
+    {
+        if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+            switch (section) {
+            case Column::Code: return "Kode";
+            case Column::Name: return "Nama Produk";
+            case Column::Quantity: return "Kwantitas";
+            case Column::Price1: return "Harga 1";
+            case Column::Price2: return "Harga 2";
+            case Column::Price3: return "Harga 3";
+            }
+        }
+
+        return QVariant();
+    }
+
+    QVariant data(const QModelIndex& index, int role) const
+    {
+        if (!index.isValid())
+            return QVariant();
+
+        const BulkRepricer::Change& change = changes.at(index.row());
+
+        if (role == Qt::DisplayRole) {
+            switch (index.column()) {
+            case Column::Code: return Product::formatCode(change.productId);
+            case Column::Name: return change.productName;
+            case Column::Quantity: return quantityString(change.before);
+            case Column::Price1:
+            case Column::Price2:
+            case Column::Price3: {
+                int level = index.column() - Column::Price1;
+                QString before = priceString(change.before, level);
+                QString after = priceString(change.after, level);
+                if (before == after)
+                    return before;
+                return QString("%1 → %2").arg(before.isEmpty() ? "-" : before, after);
+            }
+            }
+        }
+        else if (role == Qt::TextAlignmentRole) {
+            if (index.column() >= Column::Quantity)
+                return Qt::AlignCenter;
+        }
+
+        return QVariant();
+    }
+
+private:
+    QString quantityString(const PriceTable::Tier& tier) const
+    {
+        if (tier.isOpenEnded())
+            return QString(">= %1").arg(_locale.toString(tier.quantityMin));
+        if (tier.quantityMin == tier.quantityMax)
+            return _locale.toString(tier.quantityMin);
+        return QString("%1 - %2").arg(_locale.toString(tier.quantityMin), _locale.toString(tier.quantityMax));
+    }
+
+    QString priceString(const PriceTable::Tier& tier, int level) const
+    {
+        quint64 min = tier.priceMin[level];
+        quint64 max = tier.priceMax[level];
+        if (!min && !max)
+            return QString();
+        if (min == max)
+            return _locale.toString(max);
+        return QString("%1 - %2").arg(_locale.toString(min), _locale.toString(max));
+    }
+
+    QLocale _locale;
+};
+
+RepriceDialog::RepriceDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Ubah Harga Massal");
+
+    _typeComboBox = new QComboBox(this);
+    _typeComboBox->addItem("Semua Jenis", -1);
+    _typeComboBox->addItem(Product::typeString(Product::Type::Stocked), Product::Type::Stocked);
+    _typeComboBox->addItem(Product::typeString(Product::Type::NonStocked), Product::Type::NonStocked);
+    _typeComboBox->addItem(Product::typeString(Product::Type::Service), Product::Type::Service);
+    connect(_typeComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onInputChanged()));
+
+    _statusComboBox = new QComboBox(this);
+    _statusComboBox->addItem("Semua Status", -1);
+    _statusComboBox->addItem("Aktif", 1);
+    _statusComboBox->addItem("Nonaktif", 0);
+    connect(_statusComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onInputChanged()));
+
+    _nameEdit = new QLineEdit(this);
+    _nameEdit->setPlaceholderText("Semua nama");
+    connect(_nameEdit, SIGNAL(textChanged(QString)), SLOT(_onInputChanged()));
+
+    _ruleComboBox = new QComboBox(this);
+    _ruleComboBox->addItem("Markup dari modal (%)", BulkRepricer::Rule::MarkupOnCost);
+    _ruleComboBox->addItem("Tambah / kurangi harga (Rp)", BulkRepricer::Rule::FixedDelta);
+    connect(_ruleComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onRuleChanged()));
+
+    _roundingComboBox = new QComboBox(this);
+    _roundingComboBox->addItem("Tanpa pembulatan", 0);
+    _roundingComboBox->addItem("Ke 100 terdekat", 100);
+    _roundingComboBox->addItem("Ke 500 terdekat", 500);
+    connect(_roundingComboBox, SIGNAL(currentIndexChanged(int)), SLOT(_onInputChanged()));
+
+    QGridLayout* levelLayout = new QGridLayout;
+    for (int i = 0; i < PriceTable::LevelCount; i++) {
+        _levelCheckBoxes[i] = new QCheckBox(QString("Harga %1").arg(i + 1), this);
+        _levelCheckBoxes[i]->setChecked(true);
+        connect(_levelCheckBoxes[i], SIGNAL(toggled(bool)), SLOT(_onInputChanged()));
+        _levelSpinBoxes[i] = new QDoubleSpinBox(this);
+        connect(_levelSpinBoxes[i], SIGNAL(valueChanged(double)), SLOT(_onInputChanged()));
+        connect(_levelCheckBoxes[i], SIGNAL(toggled(bool)), _levelSpinBoxes[i], SLOT(setEnabled(bool)));
+        levelLayout->addWidget(_levelCheckBoxes[i], 0, i);
+        levelLayout->addWidget(_levelSpinBoxes[i], 1, i);
+    }
+
+    QFormLayout* formLayout = new QFormLayout;
+    formLayout->addRow("Jenis:", _typeComboBox);
+    formLayout->addRow("Status:", _statusComboBox);
+    formLayout->addRow("Nama:", _nameEdit);
+    formLayout->addRow("Aturan:", _ruleComboBox);
+    formLayout->addRow(levelLayout);
+    formLayout->addRow("Pembulatan:", _roundingComboBox);
+
+    QPushButton* previewButton = new QPushButton("&Pratinjau", this);
+    connect(previewButton, SIGNAL(clicked(bool)), SLOT(preview()));
+
+    _model = new Model(this);
+
+    _view = new QTableView(this);
+    _view->setAlternatingRowColors(true);
+    _view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _view->horizontalHeader()->setHighlightSections(false);
+    _view->verticalHeader()->setDefaultSectionSize(20);
+    _view->verticalHeader()->setVisible(false);
+    _view->setModel(_model);
+
+    _summaryLabel = new QLabel(this);
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(this);
+    _applyButton = buttonBox->addButton("&Terapkan", QDialogButtonBox::AcceptRole);
+    _applyButton->setEnabled(false);
+    buttonBox->addButton("&Tutup", QDialogButtonBox::RejectRole);
+    connect(buttonBox, SIGNAL(accepted()), SLOT(apply()));
+    connect(buttonBox, SIGNAL(rejected()), SLOT(reject()));
+
+    QBoxLayout* previewLayout = new QHBoxLayout;
+    previewLayout->addWidget(_summaryLabel, 1);
+    previewLayout->addWidget(previewButton);
+
+    QBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addLayout(previewLayout);
+    mainLayout->addWidget(_view, 1);
+    mainLayout->addWidget(buttonBox);
+
+    _onRuleChanged();
+    resize(800, 600);
+}
+
+QList<quint16> RepriceDialog::changedProductIds() const
+{
+    QSet<quint16> ids;
+    for (const BulkRepricer::Change& change: _model->changes)
+        ids.insert(change.productId);
+    return ids.toList();
+}
+
+void RepriceDialog::preview()
+{
+    BulkRepricer::Filter filter;
+    filter.type = _typeComboBox->currentData().toInt();
+    filter.active = _statusComboBox->currentData().toInt();
+    filter.name = _nameEdit->text().trimmed();
+
+    BulkRepricer::Rule rule;
+    rule.kind = BulkRepricer::Rule::Kind(_ruleComboBox->currentData().toInt());
+    rule.rounding = _roundingComboBox->currentData().toULongLong();
+    for (int i = 0; i < PriceTable::LevelCount; i++) {
+        rule.levels[i] = _levelCheckBoxes[i]->isChecked();
+        rule.markup[i] = _levelSpinBoxes[i]->value();
+        rule.delta[i] = qint64(_levelSpinBoxes[i]->value());
+    }
+
+    QVector<BulkRepricer::Change> changes;
+    QVector<BulkRepricer::Change>* result = &changes;
+    BackgroundJobDialog dialog("Pratinjau Harga", "Menghitung %1 dari %2 tingkat harga...",
+                               [filter, rule, result](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+        return BulkRepricer::preview(filter, rule, result, progress, error);
+    }, this);
+    if (dialog.exec() != QDialog::Accepted) {
+        if (!dialog.wasCanceled())
+            QMessageBox::warning(0, "Peringatan", QString("Gagal menghitung harga baru: %1").arg(dialog.errorString()));
+        return;
+    }
+
+    _model->setChanges(changes);
+    _summaryLabel->setText(QString("%1 tingkat harga dari %2 produk akan berubah.")
+                           .arg(QLocale().toString(_model->changes.size()))
+                           .arg(QLocale().toString(changedProductIds().size())));
+    _applyButton->setEnabled(!_model->changes.isEmpty());
+}
+
+void RepriceDialog::apply()
+{
+    if (_model->changes.isEmpty())
+        return;
+
+    if (QMessageBox::question(0, "Konfirmasi", QString("Ubah %1 tingkat harga?")
+                              .arg(QLocale().toString(_model->changes.size())), "&Ya", "&Tidak"))
+        return;
+
+    const QVector<BulkRepricer::Change> changes = _model->changes;
+    BackgroundJobDialog dialog("Ubah Harga Massal", "Menyimpan %1 dari %2 tingkat harga...",
+                               [changes](const BackgroundJobDialog::ProgressCallback& progress, QString* error) {
+        return BulkRepricer::apply(changes, progress, error);
+    }, this);
+    if (dialog.exec() != QDialog::Accepted) {
+        // Cancelling rolls everything back, the preview still stands
+        if (!dialog.wasCanceled())
+            QMessageBox::warning(0, "Peringatan", QString("Gagal menyimpan harga baru: %1\nBuat pratinjau ulang lalu terapkan kembali.").arg(dialog.errorString()));
+        return;
+    }
+
+    accept();
+}
+
+void RepriceDialog::_onRuleChanged()
+{
+    bool markup = _ruleComboBox->currentData().toInt() == BulkRepricer::Rule::MarkupOnCost;
+    for (int i = 0; i < PriceTable::LevelCount; i++) {
+        QDoubleSpinBox* spinBox = _levelSpinBoxes[i];
+        spinBox->setDecimals(markup ? 2 : 0);
+        spinBox->setRange(markup ? -100 : -999999999, markup ? 10000 : 999999999);
+        spinBox->setSingleStep(markup ? 1 : 100);
+        spinBox->setSuffix(markup ? " %" : "");
+        spinBox->setPrefix(markup ? "" : "Rp ");
+    }
+    _onInputChanged();
+}
+
+void RepriceDialog::_onInputChanged()
+{
+    // A preview only stands for the inputs it was computed from
+    if (!_model->changes.isEmpty()) {
+        QVector<BulkRepricer::Change> none;
+        _model->setChanges(none);
+    }
+    _summaryLabel->setText("Tekan Pratinjau untuk melihat perubahan harga.");
+    _applyButton->setEnabled(false);
+}
+
+#include "repricedialog.moc"
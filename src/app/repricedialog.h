@@ -0,0 +1,49 @@
+#ifndef REPRICEDIALOG_H
+#define REPRICEDIALOG_H
+
+#include <QDialog>
+
+class QComboBox;
+class QLineEdit;
+class QCheckBox;
+class QDoubleSpinBox;
+class QTableView;
+class QLabel;
+class QPushButton;
+
+class RepriceDialog : public QDialog
+{
+    Q_OBJECT
+
+private:
+    class Model;
+
+public:
+    explicit RepriceDialog(QWidget *parent = 0);
+
+    // Products whose prices were changed by the last apply
+    QList<quint16> changedProductIds() const;
+
+public slots:
+    void preview();
+    void apply();
+
+private slots:
+    void _onRuleChanged();
+    void _onInputChanged();
+
+private:
+    Model* _model;
+    QComboBox* _typeComboBox;
+    QComboBox* _statusComboBox;
+    QLineEdit* _nameEdit;
+    QComboBox* _ruleComboBox;
+    QComboBox* _roundingComboBox;
+    QCheckBox* _levelCheckBoxes[3];
+    QDoubleSpinBox* _levelSpinBoxes[3];
+    QTableView* _view;
+    QLabel* _summaryLabel;
+    QPushButton* _applyButton;
+};
+
+#endif // REPRICEDIALOG_H
@@ -0,0 +1,30 @@
+#include "sql.h"
+#include "sqlstats.h"
+#include "trace.h"
+
+#include <QSqlQuery>
+#include <QElapsedTimer>
+
+bool Sql::exec(QSqlQuery& q)
+{
+    Trace::Scope scope("SQL", "sql");
+    scope.setDetail(q.lastQuery());
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = q.exec();
+    SqlStats::record(q, q.lastQuery(), timer.nsecsElapsed() / 1000, ok);
+    return ok;
+}
+
+bool Sql::exec(QSqlQuery& q, const QString& query)
+{
+    Trace::Scope scope("SQL", "sql");
+    scope.setDetail(query);
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = q.exec(query);
+    SqlStats::record(q, query, timer.nsecsElapsed() / 1000, ok);
+    return ok;
+}
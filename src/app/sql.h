@@ -0,0 +1,16 @@
+#ifndef SQL_H
+#define SQL_H
+
+#include <QString>
+
+class QSqlQuery;
+
+// Every statement goes through here, so it is traced and counted in one place
+class Sql
+{
+public:
+    static bool exec(QSqlQuery& q);
+    static bool exec(QSqlQuery& q, const QString& query);
+};
+
+#endif // SQL_H
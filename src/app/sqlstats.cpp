@@ -0,0 +1,243 @@
+#include "sqlstats.h"
+
+#include <QSqlQuery>
+#include <QSqlDriver>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QMapIterator>
+#include <QStringList>
+#include <QRegularExpression>
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Four buckets per power of two from 1 us, the last one also takes anything slower than ~70 s
+const int BucketCount = 104;
+
+int bucketOf(qint64 elapsed)
+{
+    if (elapsed <= 1)
+        return 0;
+    int bucket = int(std::floor(4.0 * std::log2(double(elapsed))));
+    return qMin(bucket, BucketCount - 1);
+}
+
+qint64 bucketUpperBound(int bucket)
+{
+    return qint64(std::ceil(std::exp2((bucket + 1) / 4.0)));
+}
+
+struct Entry
+{
+    qint64 count;
+    qint64 errors;
+    qint64 rows;
+    qint64 totalTime;
+    qint64 maxTime;
+    QVector<qint64> buckets;
+
+    Entry() : count(0), errors(0), rows(0), totalTime(0), maxTime(0), buckets(BucketCount, 0) {}
+};
+
+QMutex mutex;
+QHash<QString, Entry> entries;
+int slowThreshold = 200;
+qint64 slowCount = 0;
+
+qint64 percentile(const QVector<qint64>& buckets, qint64 count, double fraction)
+{
+    qint64 rank = qint64(std::ceil(count * fraction));
+    qint64 seen = 0;
+    for (int i = 0; i < buckets.size(); i++) {
+        seen += buckets.at(i);
+        if (seen >= rank && seen > 0)
+            return bucketUpperBound(i);
+    }
+    return 0;
+}
+
+SqlStats::Summary summarize(const QString& statement, const Entry& entry)
+{
+    SqlStats::Summary summary;
+    summary.statement = statement;
+    summary.count = entry.count;
+    summary.errors = entry.errors;
+    summary.rows = entry.rows;
+    summary.totalTime = entry.totalTime;
+    summary.maxTime = entry.maxTime;
+    summary.p50 = qMin(percentile(entry.buckets, entry.count, 0.50), entry.maxTime);
+    summary.p95 = qMin(percentile(entry.buckets, entry.count, 0.95), entry.maxTime);
+    summary.p99 = qMin(percentile(entry.buckets, entry.count, 0.99), entry.maxTime);
+    return summary;
+}
+
+QString milliseconds(qint64 microseconds)
+{
+    return QString::number(microseconds / 1000.0, 'f', 1);
+}
+
+}
+
+void SqlStats::record(const QSqlQuery& q, const QString& query, qint64 elapsed, bool ok)
+{
+    int rows = -1;
+    if (ok) {
+        // size() is only known when the driver buffers the result, MySQL does
+        if (q.isSelect())
+            rows = q.driver() && q.driver()->hasFeature(QSqlDriver::QuerySize) ? q.size() : -1;
+        else
+            rows = q.numRowsAffected();
+    }
+
+    QString statement = normalized(query);
+    bool slow = false;
+    {
+        QMutexLocker locker(&mutex);
+        Entry& entry = entries[statement];
+        entry.count++;
+        if (!ok)
+            entry.errors++;
+        if (rows > 0)
+            entry.rows += rows;
+        entry.totalTime += elapsed;
+        entry.maxTime = qMax(entry.maxTime, elapsed);
+        entry.buckets[bucketOf(elapsed)]++;
+
+        slow = slowThreshold > 0 && elapsed >= qint64(slowThreshold) * 1000;
+        if (slow)
+            slowCount++;
+    }
+
+    if (slow) {
+        QStringList values;
+        QMapIterator<QString, QVariant> it(q.boundValues());
+        while (it.hasNext()) {
+            it.next();
+            values << QString("%1=%2").arg(it.key(), it.value().toString());
+        }
+        qWarning().noquote() << QString("Slow query (%1 ms, %2 rows): %3 [%4]")
+                                .arg(milliseconds(elapsed)).arg(rows).arg(query, values.join(", "));
+    }
+}
+
+int SqlStats::slowQueryThreshold()
+{
+    QMutexLocker locker(&mutex);
+    return slowThreshold;
+}
+
+void SqlStats::setSlowQueryThreshold(int milliseconds)
+{
+    QMutexLocker locker(&mutex);
+    slowThreshold = milliseconds;
+}
+
+qint64 SqlStats::slowQueryCount()
+{
+    QMutexLocker locker(&mutex);
+    return slowCount;
+}
+
+QList<SqlStats::Summary> SqlStats::summaries()
+{
+    QList<Summary> result;
+    {
+        QMutexLocker locker(&mutex);
+        for (QHash<QString, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+            result << summarize(it.key(), it.value());
+    }
+
+    std::sort(result.begin(), result.end(), [](const Summary& a, const Summary& b) {
+        return a.totalTime > b.totalTime;
+    });
+    return result;
+}
+
+SqlStats::Summary SqlStats::overall()
+{
+    Entry total;
+
+    QMutexLocker locker(&mutex);
+    for (const Entry& entry: entries) {
+        total.count += entry.count;
+        total.errors += entry.errors;
+        total.rows += entry.rows;
+        total.totalTime += entry.totalTime;
+        total.maxTime = qMax(total.maxTime, entry.maxTime);
+        for (int i = 0; i < BucketCount; i++)
+            total.buckets[i] += entry.buckets.at(i);
+    }
+
+    return summarize(QString(), total);
+}
+
+QString SqlStats::report(int limit)
+{
+    QList<Summary> list = summaries();
+
+    QStringList lines;
+    lines << "   count  errors      rows   total ms     p50     p95     p99     max  statement";
+    for (int i = 0; i < list.size() && i < limit; i++) {
+        const Summary& s = list.at(i);
+        lines << QString("%1 %2 %3 %4 %5 %6 %7 %8  %9")
+                 .arg(s.count, 8).arg(s.errors, 7).arg(s.rows, 9)
+                 .arg(milliseconds(s.totalTime), 10)
+                 .arg(milliseconds(s.p50), 7).arg(milliseconds(s.p95), 7).arg(milliseconds(s.p99), 7)
+                 .arg(milliseconds(s.maxTime), 7)
+                 .arg(s.statement);
+    }
+
+    return lines.join('\n');
+}
+
+void SqlStats::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    slowCount = 0;
+}
+
+QString SqlStats::normalized(const QString& query)
+{
+    QString result;
+    result.reserve(query.size());
+
+    // Quoted strings and numbers become '?', whitespace runs a single space
+    for (int i = 0; i < query.size(); i++) {
+        QChar c = query.at(i);
+        if (c == '\'' || c == '"') {
+            int end = i + 1;
+            while (end < query.size() && query.at(end) != c)
+                end += query.at(end) == '\\' ? 2 : 1;
+            result += '?';
+            i = end;
+        }
+        else if (c.isDigit() && (result.isEmpty() || !(result.at(result.size() - 1).isLetterOrNumber()
+                                                       || result.at(result.size() - 1) == '_'))) {
+            while (i + 1 < query.size() && (query.at(i + 1).isDigit() || query.at(i + 1) == '.'))
+                i++;
+            result += '?';
+        }
+        else if (c.isSpace()) {
+            if (!result.isEmpty() && result.at(result.size() - 1) != ' ')
+                result += ' ';
+        }
+        else {
+            result += c;
+        }
+    }
+
+    // Lists, multi-row inserts and CASE updates of any length are one statement
+    static const QRegularExpression list("\\(\\?(\\s*,\\s*\\?)+\\)");
+    static const QRegularExpression rows("\\(\\?\\.\\.\\.\\)(\\s*,\\s*\\(\\?\\.\\.\\.\\))+");
+    static const QRegularExpression cases("( when \\? then \\?)+");
+    result.replace(list, "(?...)");
+    result.replace(rows, "(?...)...");
+    result.replace(cases, " when ? then ?...");
+
+    return result.trimmed();
+}
@@ -0,0 +1,48 @@
+#ifndef SQLSTATS_H
+#define SQLSTATS_H
+
+#include <QString>
+#include <QList>
+
+class QSqlQuery;
+
+// Latency, row and error counts per statement, fed by Sql::exec().
+// Statements are grouped by their text with literals replaced by '?', so
+// "where id in (1,2,3)" and "where id in (4,5)" count as one statement.
+// Statements slower than the threshold are logged with their bound values.
+class SqlStats
+{
+public:
+    struct Summary
+    {
+        QString statement;
+        qint64 count;
+        qint64 errors;
+        qint64 rows;
+        qint64 totalTime;
+        qint64 maxTime;
+        // Microseconds, upper bounds of the histogram buckets they fall in
+        qint64 p50;
+        qint64 p95;
+        qint64 p99;
+
+        Summary() : count(0), errors(0), rows(0), totalTime(0), maxTime(0), p50(0), p95(0), p99(0) {}
+    };
+
+    static void record(const QSqlQuery& q, const QString& query, qint64 elapsed, bool ok);
+
+    // Milliseconds, 0 turns the slow query log off
+    static int slowQueryThreshold();
+    static void setSlowQueryThreshold(int milliseconds);
+    static qint64 slowQueryCount();
+
+    // Slowest total time first
+    static QList<Summary> summaries();
+    static Summary overall();
+    static QString report(int limit = 20);
+    static void clear();
+
+    static QString normalized(const QString& query);
+};
+
+#endif // SQLSTATS_H
@@ -0,0 +1,174 @@
+#include "trace.h"
+
+#include <QMutex>
+#include <QVector>
+#include <QHash>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    const char* category;
+    qint64 start;
+    qint64 duration;
+    int thread;
+    QString detail;
+};
+
+// A long session is cut off here rather than growing without bound
+const int MaxEvents = 1000000;
+
+QMutex mutex;
+QVector<Event> events;
+QHash<Qt::HANDLE, int> threadIds;
+QVector<QString> threadNames;
+int droppedEvents = 0;
+QElapsedTimer clock;
+QString tracePath;
+
+QString escaped(const QString& text)
+{
+    QString result;
+    result.reserve(text.size() + 2);
+    for (QChar c: text) {
+        switch (c.unicode()) {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (c.unicode() < 0x20)
+                result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+            else
+                result += c;
+        }
+    }
+    return result;
+}
+
+}
+
+QAtomicInt Trace::_enabled;
+
+void Trace::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&mutex);
+    if (!clock.isValid())
+        clock.start();
+    _enabled.storeRelease(enabled ? 1 : 0);
+}
+
+QString Trace::outputPath()
+{
+    QMutexLocker locker(&mutex);
+    return tracePath;
+}
+
+void Trace::setOutputPath(const QString& path)
+{
+    QMutexLocker locker(&mutex);
+    tracePath = path;
+}
+
+void Trace::clear()
+{
+    QMutexLocker locker(&mutex);
+    events.clear();
+    droppedEvents = 0;
+}
+
+qint64 Trace::now()
+{
+    return clock.nsecsElapsed() / 1000;
+}
+
+void Trace::record(const char* name, const char* category, qint64 start, qint64 duration, const QString& detail)
+{
+    Qt::HANDLE handle = QThread::currentThreadId();
+
+    QMutexLocker locker(&mutex);
+    if (events.size() >= MaxEvents) {
+        droppedEvents++;
+        return;
+    }
+
+    int thread = threadIds.value(handle, -1);
+    if (thread == -1) {
+        thread = threadNames.size();
+        threadIds.insert(handle, thread);
+
+        QString threadName = QThread::currentThread()->objectName();
+        if (threadName.isEmpty()) {
+            threadName = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()
+                    ? QString("GUI") : QString("Thread %1").arg(thread);
+        }
+        threadNames << threadName;
+    }
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.duration = duration;
+    event.thread = thread;
+    event.detail = detail;
+    events << event;
+}
+
+bool Trace::writeChromeTrace(const QString& path)
+{
+    QVector<Event> snapshot;
+    QVector<QString> names;
+    int dropped;
+    {
+        QMutexLocker locker(&mutex);
+        snapshot = events;
+        names = threadNames;
+        dropped = droppedEvents;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        qWarning() << "Unable to write trace:" << qPrintable(file.errorString());
+        return false;
+    }
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for (int i = 0; i < names.size(); i++) {
+        out << (first ? "" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+            << ",\"args\":{\"name\":\"" << escaped(names.at(i)) << "\"}}";
+        first = false;
+    }
+
+    for (const Event& event: snapshot) {
+        out << (first ? "" : ",\n")
+            << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+        if (!event.detail.isEmpty())
+            out << ",\"args\":{\"detail\":\"" << escaped(event.detail) << "\"}";
+        out << '}';
+        first = false;
+    }
+
+    out << "\n]}\n";
+    out.flush();
+
+    if (dropped)
+        qWarning() << "Trace buffer was full," << dropped << "spans were not recorded";
+
+    return file.commit();
+}
@@ -0,0 +1,67 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QAtomicInt>
+
+// Records timed spans and writes them as Chrome trace-event JSON, which
+// chrome://tracing and ui.perfetto.dev open as a timeline.
+// While tracing is off a span only reads one flag.
+class Trace
+{
+public:
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name, const char* category = "app")
+            : _name(name)
+            , _category(category)
+            , _start(Trace::isEnabled() ? Trace::now() : -1)
+        {}
+
+        ~Scope()
+        {
+            if (_start >= 0)
+                Trace::record(_name, _category, _start, Trace::now() - _start, _detail);
+        }
+
+        // Shown as the span's argument, e.g. the SQL text
+        void setDetail(const QString& detail)
+        {
+            if (_start >= 0)
+                _detail = detail;
+        }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+
+        const char* _name;
+        const char* _category;
+        qint64 _start;
+        QString _detail;
+    };
+
+    static bool isEnabled() { return _enabled.loadAcquire(); }
+    static void setEnabled(bool enabled);
+
+    static QString outputPath();
+    static void setOutputPath(const QString& path);
+
+    static void clear();
+    static bool writeChromeTrace(const QString& path);
+    static bool writeChromeTrace() { return writeChromeTrace(outputPath()); }
+
+    // Microseconds since tracing was first enabled
+    static qint64 now();
+    static void record(const char* name, const char* category, qint64 start, qint64 duration,
+                       const QString& detail = QString());
+
+private:
+    static QAtomicInt _enabled;
+};
+
+#define SIMS_TRACE_CONCAT_(a, b) a##b
+#define SIMS_TRACE_CONCAT(a, b) SIMS_TRACE_CONCAT_(a, b)
+#define SIMS_TRACE_SCOPE(name) Trace::Scope SIMS_TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,27 @@
+TARGET = shift-ims-bench
+TEMPLATE = app
+DESTDIR = $$PWD/../../dist
+QT = core gui widgets sql concurrent testlib
+CONFIG += console
+
+GENERATOR_DIR = $$PWD/../generator
+INCLUDEPATH += $$GENERATOR_DIR
+
+include(../app/app.pri)
+
+SOURCES += \
+    main.cpp \
+    benchcatalog.cpp \
+    productlistmodelbench.cpp \
+    productlistviewbench.cpp \
+    producteditormodelbench.cpp \
+    $$GENERATOR_DIR/catalogschema.cpp \
+    $$GENERATOR_DIR/cataloggenerator.cpp
+
+HEADERS += \
+    benchcatalog.h \
+    productlistmodelbench.h \
+    productlistviewbench.h \
+    producteditormodelbench.h \
+    $$GENERATOR_DIR/catalogschema.h \
+    $$GENERATOR_DIR/cataloggenerator.h
@@ -0,0 +1,43 @@
+#include "benchcatalog.h"
+#include "connectionpool.h"
+#include "catalogschema.h"
+#include "cataloggenerator.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QDebug>
+
+bool BenchCatalog::open()
+{
+    // Named shared-cache memory database, alive as long as the main thread keeps its connection
+    ConnectionPool::Settings settings;
+    settings.driverName = "QSQLITE";
+    settings.databaseName = "file:shift-ims-bench?mode=memory&cache=shared";
+    settings.connectOptions = "QSQLITE_OPEN_URI";
+    ConnectionPool::instance()->setSettings(settings);
+
+    QSqlDatabase db = ConnectionPool::instance()->database();
+    if (!db.isOpen()) {
+        qCritical() << "Database connection failed:" << qPrintable(db.lastError().text());
+        return false;
+    }
+
+    return CatalogSchema::create(db);
+}
+
+bool BenchCatalog::populate(int productCount)
+{
+    // One writer, the shared in-memory database locks whole tables
+    CatalogGenerator::Options options;
+    options.products = productCount;
+    options.threads = 1;
+    return CatalogGenerator::generate(options);
+}
+
+int BenchCatalog::productCount()
+{
+    // Product ids are 16 bit in the application
+    bool ok = false;
+    int count = qgetenv("SIMS_BENCH_PRODUCTS").toInt(&ok);
+    return ok && count > 0 ? qMin(count, 65535) : 20000;
+}
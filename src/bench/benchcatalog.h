@@ -0,0 +1,18 @@
+#ifndef BENCHCATALOG_H
+#define BENCHCATALOG_H
+
+#include <QtGlobal>
+
+// Generated product catalog in a shared in-memory SQLite database, so the
+// benchmarks run on any box without MySQL. The shared cache lets the
+// product list loader thread open its own connection to the same data.
+class BenchCatalog
+{
+public:
+    static bool open();
+    static bool populate(int productCount);
+
+    static int productCount();
+};
+
+#endif // BENCHCATALOG_H
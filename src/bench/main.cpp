@@ -0,0 +1,39 @@
+#include <QApplication>
+#include <QLocale>
+#include <QStandardPaths>
+#include <QtTest>
+
+#include "benchcatalog.h"
+#include "productlistmodelbench.h"
+#include "productlistviewbench.h"
+#include "producteditormodelbench.h"
+
+int main(int argc, char **argv)
+{
+    // Runs headless unless a platform is asked for explicitly
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    // Keeps the product list snapshot away from the real cache directory
+    QStandardPaths::setTestModeEnabled(true);
+
+    QLocale::setDefault(QLocale(QLocale::Indonesian, QLocale::Indonesia));
+
+    if (!BenchCatalog::open() || !BenchCatalog::populate(BenchCatalog::productCount()))
+        return 2;
+
+    int status = 0;
+
+    ProductListModelBench productListModelBench;
+    status |= QTest::qExec(&productListModelBench, argc, argv);
+
+    ProductListViewBench productListViewBench;
+    status |= QTest::qExec(&productListViewBench, argc, argv);
+
+    ProductEditorModelBench productEditorModelBench;
+    status |= QTest::qExec(&productEditorModelBench, argc, argv);
+
+    return status;
+}
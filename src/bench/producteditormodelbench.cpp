@@ -0,0 +1,75 @@
+#include "producteditormodelbench.h"
+#include "producteditor.h"
+#include "ui_producteditor.h"
+
+#include <QtTest>
+#include <QTableView>
+
+void ProductEditorModelBench::uomSetData_data()
+{
+    QTest::addColumn<bool>("duplicate");
+
+    QTest::newRow("unique") << false;
+    QTest::newRow("duplicate") << true;
+}
+
+// Renaming units of a full unit table, every name is checked against the other units
+void ProductEditorModelBench::uomSetData()
+{
+    QFETCH(bool, duplicate);
+
+    ProductEditor editor(0);
+    QAbstractItemModel* model = editor.ui->uomTableView->model();
+
+    for (int row = 0; row < 5 && row < model->rowCount(); row++) {
+        QVERIFY(model->setData(model->index(row, 0), QString("Satuan %1").arg(row)));
+        QVERIFY(model->setData(model->index(row, 1), (row + 1) * 12));
+    }
+    int rowCount = model->rowCount();
+
+    // Alternating between two names keeps every unique rename accepted
+    QStringList names[2];
+    for (int row = 0; row < rowCount; row++) {
+        names[0] << QString("Satuan %1").arg(row);
+        names[1] << QString("Kemasan %1").arg(row);
+    }
+
+    int round = 0;
+    QBENCHMARK {
+        round ^= 1;
+        for (int row = 0; row < rowCount; row++) {
+            QString name = duplicate ? names[0].at((row + 1) % rowCount) : names[round].at(row);
+            model->setData(model->index(row, 0), name);
+        }
+    }
+}
+
+void ProductEditorModelBench::priceSetData_data()
+{
+    QTest::addColumn<int>("column");
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("quantity single") << 0 << "12";
+    QTest::newRow("quantity range") << 0 << "1.000 - 5.000";
+    QTest::newRow("quantity minimum") << 0 << ">= 10.000";
+    QTest::newRow("price single") << 1 << "15.500";
+    QTest::newRow("price range") << 2 << "14.000 - 15.500";
+    QTest::newRow("invalid") << 1 << "abc - def - ghi";
+}
+
+void ProductEditorModelBench::priceSetData()
+{
+    QFETCH(int, column);
+    QFETCH(QString, text);
+
+    ProductEditor editor(0);
+    QAbstractItemModel* model = editor.ui->priceTableView->model();
+
+    // Fill the first row so later edits do not keep appending rows
+    model->setData(model->index(0, 0), "1");
+    QModelIndex index = model->index(0, column);
+
+    QBENCHMARK {
+        model->setData(index, text);
+    }
+}
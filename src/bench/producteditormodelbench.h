@@ -0,0 +1,17 @@
+#ifndef PRODUCTEDITORMODELBENCH_H
+#define PRODUCTEDITORMODELBENCH_H
+
+#include <QObject>
+
+class ProductEditorModelBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void uomSetData_data();
+    void uomSetData();
+    void priceSetData_data();
+    void priceSetData();
+};
+
+#endif // PRODUCTEDITORMODELBENCH_H
@@ -0,0 +1,109 @@
+#include "productlistmodelbench.h"
+#include "benchcatalog.h"
+#include "productlistwidget.h"
+
+#include <QtTest>
+#include <QSortFilterProxyModel>
+
+namespace {
+
+// The list model is private to the widget, the benchmarks reach it through the view's proxy
+QAbstractItemModel* sourceModel(ProductListWidget* widget)
+{
+    return static_cast<QSortFilterProxyModel*>(widget->view->model())->sourceModel();
+}
+
+bool waitForReset(QSignalSpy* spy)
+{
+    return spy->count() > 0 || spy->wait(60000);
+}
+
+}
+
+void ProductListModelBench::initTestCase()
+{
+    _widget = new ProductListWidget;
+    QAbstractItemModel* model = sourceModel(_widget);
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), BenchCatalog::productCount(), 60000);
+}
+
+void ProductListModelBench::cleanupTestCase()
+{
+    delete _widget;
+}
+
+// A full reload: count, select and search index build on the loader thread, then the model reset
+void ProductListModelBench::refresh()
+{
+    QAbstractItemModel* model = sourceModel(_widget);
+
+    QBENCHMARK {
+        QSignalSpy spy(model, SIGNAL(modelReset()));
+        _widget->refresh();
+        QVERIFY(waitForReset(&spy));
+    }
+
+    QCOMPARE(model->rowCount(), BenchCatalog::productCount());
+}
+
+void ProductListModelBench::data_data()
+{
+    QTest::addColumn<int>("role");
+
+    QTest::newRow("DisplayRole") << int(Qt::DisplayRole);
+    QTest::newRow("EditRole") << int(Qt::EditRole);
+    QTest::newRow("TextAlignmentRole") << int(Qt::TextAlignmentRole);
+    QTest::newRow("ToolTipRole") << int(Qt::ToolTipRole);
+    QTest::newRow("DecorationRole") << int(Qt::DecorationRole);
+    QTest::newRow("FontRole") << int(Qt::FontRole);
+    QTest::newRow("ForegroundRole") << int(Qt::ForegroundRole);
+    QTest::newRow("BackgroundRole") << int(Qt::BackgroundRole);
+}
+
+// Every cell of the list once per iteration
+void ProductListModelBench::data()
+{
+    QFETCH(int, role);
+
+    QAbstractItemModel* model = sourceModel(_widget);
+    int rowCount = model->rowCount();
+    int columnCount = model->columnCount();
+
+    QBENCHMARK {
+        for (int row = 0; row < rowCount; row++) {
+            for (int column = 0; column < columnCount; column++)
+                model->data(model->index(row, column), role);
+        }
+    }
+}
+
+void ProductListModelBench::sort_data()
+{
+    QTest::addColumn<int>("column");
+
+    QAbstractItemModel* model = sourceModel(_widget);
+    for (int column = 0; column < model->columnCount(); column++)
+        QTest::newRow(qPrintable(model->headerData(column, Qt::Horizontal).toString())) << column;
+}
+
+// Sorting goes to the database, an iteration lasts until the re-sorted rows are in the model
+void ProductListModelBench::sort()
+{
+    QFETCH(int, column);
+
+    QAbstractItemModel* model = sourceModel(_widget);
+    QAbstractItemModel* proxy = _widget->view->model();
+    Qt::SortOrder order = Qt::AscendingOrder;
+
+    QBENCHMARK {
+        // The model ignores a sort it already has, so every iteration flips the order
+        order = order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+        QSignalSpy spy(model, SIGNAL(modelReset()));
+        proxy->sort(column, order);
+        QVERIFY(waitForReset(&spy));
+    }
+
+    QSignalSpy spy(model, SIGNAL(modelReset()));
+    proxy->sort(0, Qt::AscendingOrder);
+    waitForReset(&spy);
+}
@@ -0,0 +1,26 @@
+#ifndef PRODUCTLISTMODELBENCH_H
+#define PRODUCTLISTMODELBENCH_H
+
+#include <QObject>
+
+class ProductListWidget;
+
+class ProductListModelBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void refresh();
+    void data_data();
+    void data();
+    void sort_data();
+    void sort();
+
+private:
+    ProductListWidget* _widget;
+};
+
+#endif // PRODUCTLISTMODELBENCH_H
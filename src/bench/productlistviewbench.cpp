@@ -0,0 +1,37 @@
+#include "productlistviewbench.h"
+#include "benchcatalog.h"
+#include "productlistwidget.h"
+
+#include <QtTest>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+
+void ProductListViewBench::scroll_data()
+{
+    QTest::addColumn<bool>("customDelegate");
+
+    QTest::newRow("QStyledItemDelegate") << false;
+    QTest::newRow("ProductListWidget::Delegate") << true;
+}
+
+// One iteration is one frame: scroll down a page and repaint synchronously
+void ProductListViewBench::scroll()
+{
+    QFETCH(bool, customDelegate);
+
+    ProductListWidget widget;
+    widget.resize(1024, 768);
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QTRY_COMPARE_WITH_TIMEOUT(widget.view->model()->rowCount(), BenchCatalog::productCount(), 60000);
+
+    if (!customDelegate)
+        widget.view->setItemDelegate(new QStyledItemDelegate(&widget));
+
+    QScrollBar* scrollBar = widget.view->verticalScrollBar();
+    QBENCHMARK {
+        int value = scrollBar->value() + scrollBar->pageStep();
+        scrollBar->setValue(value > scrollBar->maximum() ? 0 : value);
+        widget.view->viewport()->repaint();
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef PRODUCTLISTVIEWBENCH_H
+#define PRODUCTLISTVIEWBENCH_H
+
+#include <QObject>
+
+class ProductListViewBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void scroll_data();
+    void scroll();
+};
+
+#endif // PRODUCTLISTVIEWBENCH_H
@@ -0,0 +1,256 @@
+#include "cataloggenerator.h"
+#include "connectionpool.h"
+
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QDebug>
+
+#include <QtConcurrentRun>
+#include <QFuture>
+
+namespace {
+
+const char* const Brands[] = {
+    "Indo", "Sari", "Maju", "Sinar", "Mitra", "Karya", "Sentosa", "Jaya", "Abadi", "Makmur",
+    "Nusa", "Prima", "Bintang", "Mulia", "Lestari", "Cahaya", "Sumber", "Harapan", "Tunas", "Setia",
+    "Rajawali", "Garuda", "Merpati", "Kencana", "Permata", "Mutiara", "Pelangi", "Surya", "Bumi", "Samudra",
+    0
+};
+
+struct ProductKind
+{
+    const char* name;
+    const char* baseUom;
+};
+
+const ProductKind Kinds[] = {
+    { "Sabun Mandi", "pcs" }, { "Sampo", "btl" }, { "Pasta Gigi", "pcs" }, { "Kopi Bubuk", "bks" },
+    { "Kopi Instan", "sachet" }, { "Teh Celup", "kotak" }, { "Gula Pasir", "kg" }, { "Beras", "kg" },
+    { "Minyak Goreng", "ltr" }, { "Susu Kental Manis", "klg" }, { "Susu UHT", "kotak" }, { "Roti Tawar", "bks" },
+    { "Mie Instan", "bks" }, { "Kecap Manis", "btl" }, { "Saus Sambal", "btl" }, { "Garam", "bks" },
+    { "Tepung Terigu", "kg" }, { "Telur Ayam", "kg" }, { "Air Mineral", "btl" }, { "Deterjen Bubuk", "bks" },
+    { "Sabun Cuci Piring", "btl" }, { "Pewangi Pakaian", "sachet" }, { "Biskuit", "bks" }, { "Wafer", "bks" },
+    { "Permen", "bks" }, { "Sirup", "btl" }, { "Sarden", "klg" }, { "Kornet", "klg" }, { "Tisu", "pak" },
+    { "Popok Bayi", "pak" }, { "Obat Nyamuk", "kotak" }, { "Baterai", "pcs" }, { "Korek Api", "pcs" },
+    { "Rokok", "bks" }, { "Minuman Energi", "btl" }, { "Kacang", "bks" }, { "Keripik", "bks" },
+    { "Sosis", "bks" }, { "Nugget", "bks" }, { "Es Krim", "pcs" },
+    { 0, 0 }
+};
+
+const char* const Variants[] = {
+    "Original", "Extra", "Premium", "Hemat", "Jumbo", "Mini", "Coklat", "Vanila", "Stroberi", "Jeruk",
+    "Mangga", "Melon", "Pandan", "Pedas", "Manis", "Asin", "Lemon", "Mint", "Herbal", "Susu",
+    0
+};
+
+const char* const Sizes[] = {
+    "50 g", "100 g", "200 g", "250 g", "500 g", "1 kg", "2 kg", "5 kg",
+    "100 ml", "250 ml", "600 ml", "1 L", "1,5 L", "5 L",
+    0
+};
+
+struct Packing
+{
+    const char* name;
+    quint64 quantity;
+};
+
+// Larger units of a product, smallest first
+const Packing Packings[] = {
+    { "pak", 5 }, { "renteng", 10 }, { "lusin", 12 }, { "dus", 24 }, { "karton", 48 }, { "bal", 100 }
+};
+
+int count(const char* const* list)
+{
+    int n = 0;
+    while (list[n])
+        n++;
+    return n;
+}
+
+// SplitMix64, a cheap stateless mixer: one product id in, a stream of random numbers out
+struct Random
+{
+    quint64 state;
+
+    Random(quint32 seed, quint64 id) : state((quint64(seed) << 32) ^ (id * 0x9E3779B97F4A7C15ull)) {}
+
+    quint64 next()
+    {
+        quint64 z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    int below(int n) { return int(next() % quint64(n)); }
+    bool chance(int percent) { return below(100) < percent; }
+};
+
+// Prices are whole rupiah in steps of 100 or 500 like a shelf label
+quint64 roundPrice(quint64 price)
+{
+    quint64 step = price >= 20000 ? 500 : 100;
+    return qMax(step, (price + step / 2) / step * step);
+}
+
+}
+
+bool CatalogGenerator::generate(const Options& options, const ProgressCallback& progress)
+{
+    QAtomicInt failed(0);
+    QAtomicInt done(0);
+
+    // The pool's threads end with it, which closes their pooled connections
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, options.threads));
+
+    QList<QFuture<void> > futures;
+    for (int first = 0; first < options.products; first += options.batchSize) {
+        futures << QtConcurrent::run(&pool, [first, &options, &progress, &failed, &done]() {
+            if (failed.loadAcquire())
+                return;
+
+            int batchCount = qMin(options.batchSize, options.products - first);
+            bool ok;
+            {
+                QSqlDatabase db = ConnectionPool::instance()->database();
+                ok = db.isOpen() && writeBatch(db, options, first, batchCount);
+            }
+            if (!ok) {
+                failed.storeRelease(1);
+                return;
+            }
+
+            int total = done.fetchAndAddOrdered(batchCount) + batchCount;
+            if (progress)
+                progress(total, options.products);
+        });
+    }
+
+    for (QFuture<void>& future: futures)
+        future.waitForFinished();
+
+    return !failed.loadAcquire();
+}
+
+bool CatalogGenerator::writeBatch(QSqlDatabase& db, const Options& options, int first, int count)
+{
+    static const int RowsPerStatement = 500;
+
+    QSqlDriver* driver = db.driver();
+    QSqlField textField("text", QVariant::String);
+    auto quoted = [driver, &textField](const QString& text) {
+        textField.setValue(text);
+        return driver->formatValue(textField);
+    };
+
+    int brandCount = ::count(Brands);
+    int kindCount = 0;
+    while (Kinds[kindCount].name)
+        kindCount++;
+    int variantCount = ::count(Variants);
+    int sizeCount = ::count(Sizes);
+    qint64 combinations = qint64(brandCount) * kindCount * variantCount * sizeCount;
+
+    QStringList products;
+    QStringList uoms;
+    QStringList prices;
+
+    for (int i = first; i < first + count; i++) {
+        qint64 id = qint64(options.firstId) + i;
+        Random random(options.seed, quint64(id));
+
+        // Walking the combinations in order keeps names unique, popular kinds repeat across brands
+        qint64 n = i;
+        int brand = int(n % brandCount); n /= brandCount;
+        int kind = int(n % kindCount); n /= kindCount;
+        int variant = int(n % variantCount); n /= variantCount;
+        int size = int(n % sizeCount);
+        QString name = QString("%1 %2 %3 %4").arg(Brands[brand], Kinds[kind].name, Variants[variant], Sizes[size]);
+        if (i >= combinations)
+            name += QString(" #%1").arg(i / combinations + 1);
+
+        int typeRoll = random.below(100);
+        int type = typeRoll < 80 ? 0 : typeRoll < 92 ? 1 : 2;
+        bool active = random.chance(95);
+        int costingMethod = random.below(3);
+        quint64 cost = roundPrice(1000 + random.next() % 150000);
+        quint64 averageCost = roundPrice(cost * (95 + random.below(10)) / 100);
+        quint64 lastPurchaseCost = roundPrice(cost * (95 + random.below(10)) / 100);
+        quint64 effectiveCost = costingMethod == 0 ? cost : costingMethod == 1 ? averageCost : lastPurchaseCost;
+
+        products << QString("(%1,%2,%3,%4,%5,%6,%7,%8,%9,%10)")
+                    .arg(id).arg(quoted(name)).arg(type).arg(active ? 1 : 0)
+                    .arg(quoted(Kinds[kind].baseUom)).arg(costingMethod)
+                    .arg(effectiveCost).arg(cost).arg(averageCost).arg(lastPurchaseCost);
+
+        // One to five larger units, each bigger than the one before
+        int uomCount = 1 + random.below(5);
+        int packing = random.below(2);
+        for (int u = 0; u < uomCount && packing < 6; u++, packing += 1 + random.below(2))
+            uoms << QString("(%1,%2,%3)").arg(id).arg(quoted(Packings[packing].name)).arg(Packings[packing].quantity);
+
+        // Tiers from single items up, cheaper per item the more is bought.
+        // One boundary in ten starts a tier inside the previous one, as hand-entered data does.
+        int tierCount = 1 + random.below(4);
+        quint64 basePrice = roundPrice(effectiveCost * (110 + random.below(30)) / 100);
+        quint64 quantityMin = 1;
+        for (int t = 0; t < tierCount; t++) {
+            bool last = t == tierCount - 1;
+            quint64 quantityMax = last ? 0 : quantityMin + quint64(3 + random.below(20)) * (t + 1);
+            quint64 price = roundPrice(basePrice * (100 - t * 4) / 100);
+            quint64 price2 = roundPrice(price * 97 / 100);
+            bool hasPrice3 = random.chance(30);
+
+            prices << QString("(%1,%2,%3,%4,%5,%6,%7,%8,%9)")
+                      .arg(id).arg(quantityMin).arg(quantityMax)
+                      .arg(price).arg(price)
+                      .arg(price2).arg(roundPrice(price * 99 / 100))
+                      .arg(hasPrice3 ? roundPrice(price * 92 / 100) : 0).arg(hasPrice3 ? roundPrice(price * 95 / 100) : 0);
+
+            if (last)
+                break;
+            quantityMin = quantityMax + 1;
+            if (random.chance(10))
+                quantityMin -= 1 + random.below(int(qMin<quint64>(quantityMax - 1, 3)));
+        }
+    }
+
+    struct Insert
+    {
+        const char* prefix;
+        const QStringList* rows;
+    };
+    const Insert inserts[] = {
+        { "insert into products(id, name, type, active, baseUom, costingMethod, cost, manualCost, averageCost, lastPurchaseCost) values ", &products },
+        { "insert into product_uoms(productId, name, quantity) values ", &uoms },
+        { "insert into product_prices(productId, quantityMin, quantityMax, price1Min, price1Max, price2Min, price2Max, price3Min, price3Max) values ", &prices },
+    };
+
+    db.transaction();
+    QSqlQuery q(db);
+    for (const Insert& insert: inserts) {
+        for (int row = 0; row < insert.rows->size(); row += RowsPerStatement) {
+            if (!q.exec(insert.prefix + insert.rows->mid(row, RowsPerStatement).join(','))) {
+                qCritical() << "SQL ERROR:" << qPrintable(q.lastError().text());
+                db.rollback();
+                return false;
+            }
+        }
+    }
+
+    if (!db.commit()) {
+        qCritical() << "SQL ERROR:" << qPrintable(db.lastError().text());
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
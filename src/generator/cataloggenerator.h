@@ -0,0 +1,40 @@
+#ifndef CATALOGGENERATOR_H
+#define CATALOGGENERATOR_H
+
+#include <QString>
+#include <functional>
+
+class QSqlDatabase;
+
+// Fills the catalog tables with made up but plausible products: brand,
+// product and variant names, one to five units and up to four price
+// tiers, some of them with overlapping quantity ranges.
+// Every product is derived from its id and the seed alone, so batches
+// can be written by several threads at once and the same seed always
+// gives the same catalog.
+class CatalogGenerator
+{
+public:
+    struct Options
+    {
+        int products;
+        int firstId;
+        // Products per transaction
+        int batchSize;
+        int threads;
+        quint32 seed;
+
+        Options() : products(1000), firstId(1), batchSize(2000), threads(1), seed(1) {}
+    };
+
+    // Called from the worker threads as batches commit
+    typedef std::function<void(int done, int total)> ProgressCallback;
+
+    // Connections come from the ConnectionPool, one per worker thread
+    static bool generate(const Options& options, const ProgressCallback& progress = ProgressCallback());
+
+private:
+    static bool writeBatch(QSqlDatabase& db, const Options& options, int first, int count);
+};
+
+#endif // CATALOGGENERATOR_H
@@ -0,0 +1,86 @@
+#include "catalogschema.h"
+#include "costingengine.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+
+bool execAll(QSqlDatabase& db, const QStringList& statements)
+{
+    QSqlQuery q(db);
+    for (const QString& statement: statements) {
+        if (!q.exec(statement)) {
+            qCritical() << "SQL ERROR:" << qPrintable(q.lastError().text());
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+bool CatalogSchema::create(QSqlDatabase& db)
+{
+    bool mysql = db.driverName() == "QMYSQL";
+    QString id = mysql ? "id int unsigned not null auto_increment primary key"
+                       : "id integer primary key autoincrement";
+    QString tableOptions = mysql ? " engine=InnoDB default charset=utf8mb4" : "";
+
+    QStringList statements;
+    statements << QString("create table if not exists products ("
+                          " %1,"
+                          " name varchar(100) not null,"
+                          " type tinyint unsigned not null default 0,"
+                          " active tinyint unsigned not null default 1,"
+                          " baseUom varchar(50) not null default '',"
+                          " costingMethod tinyint unsigned not null default 1,"
+                          " cost bigint not null default 0,"
+                          " manualCost bigint not null default 0,"
+                          " averageCost bigint not null default 0,"
+                          " lastPurchaseCost bigint not null default 0"
+                          "%2)%3")
+                  .arg(id, mysql ? ", unique key products_name (name)" : ", unique (name)", tableOptions)
+               << QString("create table if not exists product_uoms ("
+                          " %1,"
+                          " productId int unsigned not null,"
+                          " name varchar(50) not null,"
+                          " quantity bigint unsigned not null"
+                          "%2)%3")
+                  .arg(id, mysql ? ", key product_uoms_productId (productId)" : "", tableOptions)
+               << QString("create table if not exists product_prices ("
+                          " %1,"
+                          " productId int unsigned not null,"
+                          " quantityMin bigint unsigned not null default 0,"
+                          " quantityMax bigint unsigned not null default 0,"
+                          " price1Min bigint unsigned not null default 0,"
+                          " price1Max bigint unsigned not null default 0,"
+                          " price2Min bigint unsigned not null default 0,"
+                          " price2Max bigint unsigned not null default 0,"
+                          " price3Min bigint unsigned not null default 0,"
+                          " price3Max bigint unsigned not null default 0"
+                          "%2)%3")
+                  .arg(id, mysql ? ", key product_prices_productId (productId)" : "", tableOptions);
+
+    // SQLite has no inline secondary keys
+    if (!mysql) {
+        statements << "create index if not exists product_uoms_productId on product_uoms(productId)"
+                   << "create index if not exists product_prices_productId on product_prices(productId)";
+    }
+
+    // The costing tables ship with the application, which creates them the same way on connect
+    return execAll(db, statements) && CostingEngine::createTables(db);
+}
+
+bool CatalogSchema::drop(QSqlDatabase& db)
+{
+    return execAll(db, QStringList()
+                   << "drop table if exists product_costs"
+                   << "drop table if exists product_cost_ledger"
+                   << "drop table if exists product_prices"
+                   << "drop table if exists product_uoms"
+                   << "drop table if exists products");
+}
@@ -0,0 +1,16 @@
+#ifndef CATALOGSCHEMA_H
+#define CATALOGSCHEMA_H
+
+class QSqlDatabase;
+
+// The products, product_uoms and product_prices tables as the editor
+// reads and writes them, in the dialect of the connection's driver.
+// create() also adds the CostingEngine's tables, drop() removes them.
+class CatalogSchema
+{
+public:
+    static bool create(QSqlDatabase& db);
+    static bool drop(QSqlDatabase& db);
+};
+
+#endif // CATALOGSCHEMA_H
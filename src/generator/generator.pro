@@ -0,0 +1,32 @@
+TARGET = shift-ims-generator
+TEMPLATE = app
+DESTDIR = $$PWD/../../dist
+QT = core sql concurrent
+CONFIG += console
+
+APP_DIR = $$PWD/../app
+INCLUDEPATH += $$APP_DIR
+
+SOURCES += \
+    main.cpp \
+    catalogschema.cpp \
+    cataloggenerator.cpp \
+    scratchdatabase.cpp \
+    $$APP_DIR/connectionpool.cpp \
+    $$APP_DIR/costingengine.cpp \
+    $$APP_DIR/product.cpp \
+    $$APP_DIR/sql.cpp \
+    $$APP_DIR/sqlstats.cpp \
+    $$APP_DIR/trace.cpp
+
+HEADERS += \
+    catalogschema.h \
+    cataloggenerator.h \
+    scratchdatabase.h \
+    $$APP_DIR/global.h \
+    $$APP_DIR/connectionpool.h \
+    $$APP_DIR/costingengine.h \
+    $$APP_DIR/product.h \
+    $$APP_DIR/sql.h \
+    $$APP_DIR/sqlstats.h \
+    $$APP_DIR/trace.h
@@ -0,0 +1,102 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QDebug>
+
+#include <cstdio>
+
+#include "global.h"
+#include "connectionpool.h"
+#include "scratchdatabase.h"
+#include "catalogschema.h"
+#include "cataloggenerator.h"
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("shift-ims-generator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fills a catalog database with generated products, units and price tiers.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("sqlite", "Write to this SQLite database file.", "file"));
+    parser.addOption(QCommandLineOption("mysql", "Write to the database in this settings file. It has to be a separate"
+                                        " database, " SIMS_DEFAULT_SETTINGS_PATH " is refused.", "settings"));
+    parser.addOption(QCommandLineOption("products", "Products to generate.", "count", "10000"));
+    parser.addOption(QCommandLineOption("first-id", "Id of the first generated product.", "id", "1"));
+    parser.addOption(QCommandLineOption("batch", "Products per transaction.", "count", "2000"));
+    parser.addOption(QCommandLineOption("threads", "Parallel writers, MySQL only.", "count", QString::number(QThread::idealThreadCount())));
+    parser.addOption(QCommandLineOption("seed", "Seed, the same seed gives the same catalog.", "seed", "1"));
+    parser.addOption(QCommandLineOption("recreate", "Drop and recreate the catalog tables first."));
+    parser.process(app);
+
+    // The target is always named, so --recreate can never reach the application's tables by default
+    ConnectionPool::Settings settings;
+    bool sqlite = parser.isSet("sqlite");
+    if (sqlite == parser.isSet("mysql")) {
+        qCritical() << "Give either --sqlite or --mysql as the target database";
+        return 2;
+    }
+    if (sqlite) {
+        settings.driverName = "QSQLITE";
+        settings.databaseName = parser.value("sqlite");
+    }
+    else {
+        QString error;
+        if (!ScratchDatabase::loadSettings(parser.value("mysql"), &settings, &error)) {
+            qCritical() << qPrintable(error);
+            return 2;
+        }
+    }
+
+    CatalogGenerator::Options options;
+    options.products = qMax(0, parser.value("products").toInt());
+    options.firstId = qMax(1, parser.value("first-id").toInt());
+    options.batchSize = qMax(1, parser.value("batch").toInt());
+    // SQLite takes one writer at a time, more threads would only wait on its lock
+    options.threads = sqlite ? 1 : qMax(1, parser.value("threads").toInt());
+    options.seed = parser.value("seed").toUInt();
+
+    settings.maxSize = options.threads + 1;
+    ConnectionPool::instance()->setSettings(settings);
+
+    {
+        QSqlDatabase db = ConnectionPool::instance()->database();
+        if (!db.isOpen()) {
+            qCritical() << "Database connection failed:" << qPrintable(db.lastError().text());
+            return 2;
+        }
+
+        if (parser.isSet("recreate") && !CatalogSchema::drop(db))
+            return 2;
+        if (!CatalogSchema::create(db))
+            return 2;
+    }
+
+    if (qint64(options.firstId) + options.products - 1 > 65535)
+        qWarning() << "Product ids past 65535 are written, but the application only addresses 16 bit ids";
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutex outputMutex;
+    bool ok = CatalogGenerator::generate(options, [&timer, &outputMutex](int done, int total) {
+        QMutexLocker locker(&outputMutex);
+        double seconds = timer.elapsed() / 1000.0;
+        std::fprintf(stderr, "\r%d / %d products, %.0f products/s", done, total, seconds > 0 ? done / seconds : 0.0);
+        std::fflush(stderr);
+    });
+
+    std::fprintf(stderr, "\n");
+    if (!ok) {
+        qCritical() << "Generating the catalog failed";
+        return 1;
+    }
+
+    std::printf("%d products in %.1f s\n", options.products, timer.elapsed() / 1000.0);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "scratchdatabase.h"
+#include "global.h"
+
+#include <QFileInfo>
+
+bool ScratchDatabase::loadSettings(const QString& path, ConnectionPool::Settings* settings, QString* error)
+{
+    QFileInfo file(path);
+    if (path.isEmpty() || !file.exists()) {
+        *error = QString("Settings file %1 does not exist").arg(path);
+        return false;
+    }
+
+    QFileInfo defaultFile(SIMS_DEFAULT_SETTINGS_PATH);
+    if (defaultFile.exists() && file.canonicalFilePath() == defaultFile.canonicalFilePath()) {
+        *error = QString("%1 is the application's settings file, use one for a separate database").arg(path);
+        return false;
+    }
+
+    *settings = ConnectionPool::loadSettings(path);
+    if (settings->databaseName.isEmpty()) {
+        *error = QString("%1 names no database").arg(path);
+        return false;
+    }
+
+    if (defaultFile.exists()) {
+        ConnectionPool::Settings application = ConnectionPool::loadSettings(defaultFile.filePath());
+        if (settings->driverName == application.driverName
+                && settings->hostName == application.hostName
+                && settings->port == application.port
+                && settings->databaseName == application.databaseName) {
+            *error = QString("%1 points at the application's database %2").arg(path, application.databaseName);
+            return false;
+        }
+    }
+
+    return true;
+}
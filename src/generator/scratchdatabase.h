@@ -0,0 +1,18 @@
+#ifndef SCRATCHDATABASE_H
+#define SCRATCHDATABASE_H
+
+#include "connectionpool.h"
+
+#include <QString>
+
+// Connection settings for a database the tools may freely write to.
+// The generator and the workload driver create, overwrite and delete
+// catalog rows, so they only take an explicit settings file, never the
+// application's own, and refuse one that names the application's database.
+class ScratchDatabase
+{
+public:
+    static bool loadSettings(const QString& path, ConnectionPool::Settings* settings, QString* error);
+};
+
+#endif // SCRATCHDATABASE_H
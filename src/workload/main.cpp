@@ -0,0 +1,70 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QLocale>
+#include <QStandardPaths>
+#include <QSqlQuery>
+#include <QDebug>
+
+#include <cstdio>
+
+#include "global.h"
+#include "connectionpool.h"
+#include "scratchdatabase.h"
+#include "benchcatalog.h"
+#include "workloaddriver.h"
+
+int main(int argc, char **argv)
+{
+    // Runs headless unless a platform is asked for explicitly
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    app.setApplicationName("shift-ims-workload");
+
+    QLocale::setDefault(QLocale(QLocale::Indonesian, QLocale::Indonesia));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a scripted product management session and reports its cost.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("mysql", "Use the database in this settings file instead of an in-memory SQLite catalog."
+                                        " The workload rewrites and deletes products, so it has to be a separate benchmark"
+                                        " database, " SIMS_DEFAULT_SETTINGS_PATH " is refused.", "settings"));
+    parser.addOption(QCommandLineOption("products", "Products in the SQLite catalog.", "count", "20000"));
+    parser.addOption(QCommandLineOption("editors", "Editors to open.", "count", "50"));
+    parser.process(app);
+
+    // Keeps the product list snapshot away from the real cache directory
+    QStandardPaths::setTestModeEnabled(true);
+
+    int productCount = 0;
+    if (parser.isSet("mysql")) {
+        ConnectionPool::Settings settings;
+        QString error;
+        if (!ScratchDatabase::loadSettings(parser.value("mysql"), &settings, &error)) {
+            qCritical() << qPrintable(error);
+            return 2;
+        }
+        ConnectionPool::instance()->setSettings(settings);
+        QSqlQuery q(ConnectionPool::instance()->database());
+        if (!q.exec("select count(0) from products where type <= 200") || !q.next()) {
+            qCritical() << "Database connection failed";
+            return 2;
+        }
+        productCount = q.value(0).toInt();
+    }
+    else {
+        // Product ids are 16 bit in the application
+        productCount = qBound(1, parser.value("products").toInt(), 65535);
+        if (!BenchCatalog::open() || !BenchCatalog::populate(productCount))
+            return 2;
+    }
+
+    int editorCount = qBound(1, parser.value("editors").toInt(), productCount);
+
+    WorkloadDriver driver(productCount, editorCount);
+    bool ok = driver.run();
+
+    std::printf("%s\n", qPrintable(driver.report()));
+    return ok ? 0 : 1;
+}
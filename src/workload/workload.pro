@@ -0,0 +1,26 @@
+TARGET = shift-ims-workload
+TEMPLATE = app
+DESTDIR = $$PWD/../../dist
+QT = core gui widgets sql printsupport concurrent testlib
+CONFIG += console
+
+BENCH_DIR = $$PWD/../bench
+GENERATOR_DIR = $$PWD/../generator
+INCLUDEPATH += $$BENCH_DIR $$GENERATOR_DIR
+
+include(../app/app.pri)
+
+SOURCES += \
+    main.cpp \
+    workloaddriver.cpp \
+    $$BENCH_DIR/benchcatalog.cpp \
+    $$GENERATOR_DIR/catalogschema.cpp \
+    $$GENERATOR_DIR/cataloggenerator.cpp \
+    $$GENERATOR_DIR/scratchdatabase.cpp
+
+HEADERS += \
+    workloaddriver.h \
+    $$BENCH_DIR/benchcatalog.h \
+    $$GENERATOR_DIR/catalogschema.h \
+    $$GENERATOR_DIR/cataloggenerator.h \
+    $$GENERATOR_DIR/scratchdatabase.h
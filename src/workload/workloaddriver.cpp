@@ -0,0 +1,370 @@
+#include "workloaddriver.h"
+#include "mainwindow.h"
+#include "productmanagerwidget.h"
+#include "productlistwidget.h"
+#include "producteditor.h"
+#include "ui_producteditor.h"
+#include "databaseconnector.h"
+#include "sqlstats.h"
+
+#include <QApplication>
+#include <QTabWidget>
+#include <QTableView>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QAbstractButton>
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include <QFile>
+#include <QStringList>
+#include <QtTest>
+
+// Measures how long the GUI thread could not run its event loop.
+// A precise timer ticks every few milliseconds, a late tick means the
+// thread was busy for the extra time.
+class WorkloadDriver::StallMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Lateness below one frame is not noticeable and not counted
+    static const int Interval = 5;
+    static const int Budget = 16;
+
+    qint64 stallTime;
+    qint64 maxStall;
+
+    StallMonitor(QObject* parent)
+        : QObject(parent)
+        , stallTime(0)
+        , maxStall(0)
+    {
+        _timer.setTimerType(Qt::PreciseTimer);
+        _timer.setInterval(Interval);
+        connect(&_timer, SIGNAL(timeout()), SLOT(_onTick()));
+    }
+
+    void start()
+    {
+        stallTime = 0;
+        maxStall = 0;
+        _elapsed.start();
+        _timer.start();
+    }
+
+    void stop()
+    {
+        _onTick();
+        _timer.stop();
+    }
+
+private slots:
+    void _onTick()
+    {
+        qint64 gap = _elapsed.restart();
+        if (gap > Budget) {
+            stallTime += gap - Interval;
+            maxStall = qMax(maxStall, gap - Interval);
+        }
+    }
+
+private:
+    QTimer _timer;
+    QElapsedTimer _elapsed;
+};
+
+// Answers message boxes the way a user going through the scenario would: yes to questions, OK to warnings
+class WorkloadDriver::ModalAutoAccepter : public QObject
+{
+    Q_OBJECT
+
+public:
+    int accepted;
+
+    ModalAutoAccepter(QObject* parent)
+        : QObject(parent)
+        , accepted(0)
+    {
+        _timer.setInterval(10);
+        connect(&_timer, SIGNAL(timeout()), SLOT(_onTick()));
+        _timer.start();
+    }
+
+private slots:
+    void _onTick()
+    {
+        QMessageBox* box = qobject_cast<QMessageBox*>(QApplication::activeModalWidget());
+        if (!box)
+            return;
+
+        QList<QAbstractButton*> buttons = box->buttons();
+        if (buttons.isEmpty()) {
+            box->accept();
+        }
+        else {
+            // Custom buttons such as "&Ya" / "&Tidak" are listed in the order they were given
+            QAbstractButton* button = box->defaultButton() ? box->defaultButton() : buttons.first();
+            for (QAbstractButton* candidate: buttons) {
+                if (candidate->text() == "&Ya")
+                    button = candidate;
+            }
+            button->click();
+        }
+        accepted++;
+    }
+
+private:
+    QTimer _timer;
+};
+
+WorkloadDriver::WorkloadDriver(int productCount, int editorCount, QObject* parent)
+    : QObject(parent)
+    , _productCount(productCount)
+    , _editorCount(editorCount)
+    , _mainWindow(0)
+    , _productManager(0)
+    , _queriesBefore(0)
+    , _errorsBefore(0)
+{
+    _stallMonitor = new StallMonitor(this);
+    _modalAutoAccepter = new ModalAutoAccepter(this);
+}
+
+WorkloadDriver::~WorkloadDriver()
+{
+    delete _mainWindow;
+}
+
+bool WorkloadDriver::run()
+{
+    typedef bool (WorkloadDriver::*Scenario)();
+    struct Step { const char* name; Scenario scenario; };
+    const Step steps[] = {
+        { "startup", &WorkloadDriver::startup },
+        { "open product manager", &WorkloadDriver::openProductManager },
+        { "open editors", &WorkloadDriver::openEditors },
+        { "edit units and prices", &WorkloadDriver::editGrids },
+        { "save", &WorkloadDriver::saveEditors },
+        { "duplicate and delete", &WorkloadDriver::duplicateAndDelete },
+        { "refresh list", &WorkloadDriver::refreshList },
+    };
+
+    for (const Step& step: steps) {
+        beginScenario(step.name);
+        bool ok = (this->*step.scenario)();
+        endScenario();
+        if (!ok) {
+            qCritical() << "Scenario failed:" << step.name;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString WorkloadDriver::report() const
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6 %7")
+             .arg("scenario", -24).arg("wall ms", 10).arg("stall ms", 10).arg("max stall", 10)
+             .arg("queries", 8).arg("errors", 7).arg("peak RSS kB", 12);
+    for (const Result& result: _results) {
+        lines << QString("%1 %2 %3 %4 %5 %6 %7")
+                 .arg(result.scenario, -24).arg(result.wallTime, 10).arg(result.stallTime, 10)
+                 .arg(result.maxStall, 10).arg(result.queries, 8).arg(result.queryErrors, 7)
+                 .arg(result.peakRss, 12);
+    }
+    return lines.join('\n');
+}
+
+void WorkloadDriver::beginScenario(const QString& name)
+{
+    QApplication::processEvents();
+    resetPeakRss();
+
+    SqlStats::Summary summary = SqlStats::overall();
+    _queriesBefore = summary.count;
+    _errorsBefore = summary.errors;
+
+    _current = Result();
+    _current.scenario = name;
+    _stallMonitor->start();
+    _timer.start();
+}
+
+void WorkloadDriver::endScenario()
+{
+    _current.wallTime = _timer.elapsed();
+    _stallMonitor->stop();
+    _current.stallTime = _stallMonitor->stallTime;
+    _current.maxStall = _stallMonitor->maxStall;
+
+    SqlStats::Summary summary = SqlStats::overall();
+    _current.queries = summary.count - _queriesBefore;
+    _current.queryErrors = summary.errors - _errorsBefore;
+    _current.peakRss = peakRss();
+
+    _results << _current;
+}
+
+bool WorkloadDriver::startup()
+{
+    _mainWindow = new MainWindow;
+    _mainWindow->showMaximized();
+
+    DatabaseConnector* connector = _mainWindow->findChild<DatabaseConnector*>();
+    return connector && QTest::qWaitFor([connector]() { return connector->isReady(); }, 30000);
+}
+
+bool WorkloadDriver::openProductManager()
+{
+    _mainWindow->showProductManager();
+    _productManager = _mainWindow->findChild<ProductManagerWidget*>();
+    if (!_productManager)
+        return false;
+
+    ProductListWidget* list = _productManager->findChild<ProductListWidget*>();
+    if (!list)
+        return false;
+
+    QAbstractItemModel* model = static_cast<QSortFilterProxyModel*>(list->view->model())->sourceModel();
+    return QTest::qWaitFor([model, this]() { return model->rowCount() == _productCount; }, 60000);
+}
+
+bool WorkloadDriver::openEditors()
+{
+    // Spread over the catalog, ids start at 1
+    int step = qMax(1, _productCount / _editorCount);
+    for (int i = 0; i < _editorCount; i++) {
+        _productManager->editProduct(quint16(1 + i * step));
+        QApplication::processEvents();
+    }
+
+    return editors().size() == _editorCount;
+}
+
+bool WorkloadDriver::editGrids()
+{
+    for (ProductEditor* editor: editors()) {
+        QAbstractItemModel* uoms = editor->ui->uomTableView->model();
+        for (int row = 0; row < 3 && row < uoms->rowCount(); row++) {
+            uoms->setData(uoms->index(row, 0), QString("Kemasan %1").arg(row + 1));
+            uoms->setData(uoms->index(row, 1), (row + 1) * 6);
+        }
+
+        QAbstractItemModel* prices = editor->ui->priceTableView->model();
+        // Consecutive tiers over every stored row, so the save passes the tier validation
+        int tierCount = qMax(3, prices->rowCount() - 1);
+        for (int row = 0; row < tierCount && row < prices->rowCount(); row++) {
+            QString quantity = row == tierCount - 1
+                    ? QString(">= %1").arg(row * 6 + 1)
+                    : QString("%1 - %2").arg(row * 6 + 1).arg(row * 6 + 6);
+            prices->setData(prices->index(row, 0), quantity);
+            prices->setData(prices->index(row, 1), QLocale().toString(10000 - row * 500));
+            prices->setData(prices->index(row, 2), QLocale().toString(9500 - row * 500));
+            prices->setData(prices->index(row, 3), QString("%1 - %2").arg(QLocale().toString(9000 - row * 500),
+                                                                          QLocale().toString(9400 - row * 500)));
+        }
+        QApplication::processEvents();
+    }
+
+    return true;
+}
+
+bool WorkloadDriver::saveEditors()
+{
+    int saved = 0;
+    for (ProductEditor* editor: editors()) {
+        QSignalSpy spy(editor, SIGNAL(saved(quint16)));
+        editor->save();
+        saved += spy.count();
+        QApplication::processEvents();
+    }
+
+    return saved == _editorCount;
+}
+
+bool WorkloadDriver::duplicateAndDelete()
+{
+    QList<ProductEditor*> sources = editors().mid(0, qMax(1, _editorCount / 5));
+    int index = 0;
+    for (ProductEditor* source: sources) {
+        _productManager->duplicateProduct(source->id);
+        ProductEditor* duplicate = currentEditor();
+        if (!duplicate || duplicate == source || duplicate->id != 0)
+            return false;
+
+        duplicate->ui->nameEdit->setText(QString("Duplikat Workload %1 %2").arg(QCoreApplication::applicationPid()).arg(++index));
+
+        QSignalSpy savedSpy(duplicate, SIGNAL(saved(quint16)));
+        duplicate->save();
+        if (savedSpy.count() != 1)
+            return false;
+        QApplication::processEvents();
+
+        // remove() asks first, the auto accepter answers yes
+        QSignalSpy removedSpy(duplicate, SIGNAL(removed(quint16)));
+        duplicate->remove();
+        if (removedSpy.count() != 1)
+            return false;
+        QApplication::processEvents();
+    }
+
+    return true;
+}
+
+bool WorkloadDriver::refreshList()
+{
+    ProductListWidget* list = _productManager->findChild<ProductListWidget*>();
+    QAbstractItemModel* model = static_cast<QSortFilterProxyModel*>(list->view->model())->sourceModel();
+
+    for (int i = 0; i < 5; i++) {
+        QSignalSpy spy(model, SIGNAL(modelReset()));
+        list->refresh();
+        if (!spy.wait(60000))
+            return false;
+    }
+
+    return true;
+}
+
+ProductEditor* WorkloadDriver::currentEditor() const
+{
+    QTabWidget* tabs = _productManager->findChild<QTabWidget*>(QString(), Qt::FindDirectChildrenOnly);
+    return tabs ? qobject_cast<ProductEditor*>(tabs->currentWidget()) : 0;
+}
+
+QList<ProductEditor*> WorkloadDriver::editors() const
+{
+    QList<ProductEditor*> result;
+    QTabWidget* tabs = _productManager->findChild<QTabWidget*>(QString(), Qt::FindDirectChildrenOnly);
+    for (int i = 0; tabs && i < tabs->count(); i++) {
+        if (ProductEditor* editor = qobject_cast<ProductEditor*>(tabs->widget(i)))
+            result << editor;
+    }
+    return result;
+}
+
+// Kilobytes, from the kernel's high-water mark; 0 where /proc is not available
+qint64 WorkloadDriver::peakRss()
+{
+    QFile file("/proc/self/status");
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+        return 0;
+
+    for (QByteArray line = file.readLine(); !line.isEmpty(); line = file.readLine()) {
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+    return 0;
+}
+
+// Lets every scenario report its own peak instead of the process's
+void WorkloadDriver::resetPeakRss()
+{
+    QFile file("/proc/self/clear_refs");
+    if (file.open(QFile::WriteOnly))
+        file.write("5");
+}
+
+#include "workloaddriver.moc"
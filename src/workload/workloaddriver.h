@@ -0,0 +1,74 @@
+#ifndef WORKLOADDRIVER_H
+#define WORKLOADDRIVER_H
+
+#include <QObject>
+#include <QList>
+#include <QElapsedTimer>
+
+class MainWindow;
+class ProductManagerWidget;
+class ProductEditor;
+
+// Replays a cashier's morning against the real main window: open the
+// product manager, open editors, edit units and prices, save, duplicate,
+// delete and refresh. Every scenario is timed from the outside, the way
+// a user would feel it.
+class WorkloadDriver : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result
+    {
+        QString scenario;
+        qint64 wallTime;
+        qint64 stallTime;
+        qint64 maxStall;
+        qint64 queries;
+        qint64 queryErrors;
+        qint64 peakRss;
+    };
+
+    WorkloadDriver(int productCount, int editorCount, QObject* parent = 0);
+    ~WorkloadDriver();
+
+    bool run();
+    QList<Result> results() const { return _results; }
+    QString report() const;
+
+private:
+    class StallMonitor;
+    class ModalAutoAccepter;
+
+    void beginScenario(const QString& name);
+    void endScenario();
+
+    bool startup();
+    bool openProductManager();
+    bool openEditors();
+    bool editGrids();
+    bool saveEditors();
+    bool duplicateAndDelete();
+    bool refreshList();
+
+    ProductEditor* currentEditor() const;
+    QList<ProductEditor*> editors() const;
+
+    static qint64 peakRss();
+    static void resetPeakRss();
+
+    int _productCount;
+    int _editorCount;
+    MainWindow* _mainWindow;
+    ProductManagerWidget* _productManager;
+    StallMonitor* _stallMonitor;
+    ModalAutoAccepter* _modalAutoAccepter;
+
+    QList<Result> _results;
+    Result _current;
+    QElapsedTimer _timer;
+    qint64 _queriesBefore;
+    qint64 _errorsBefore;
+};
+
+#endif // WORKLOADDRIVER_H